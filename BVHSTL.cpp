@@ -0,0 +1,667 @@
+#include "BVHSTL.hpp"
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <algorithm>
+
+#define BVH_LEAF_SIZE 4
+#define BVH_STACK     128
+
+
+namespace BVHSTL {
+
+
+static inline BoxT
+TriangleBox(
+  const Triangle& t
+) {
+  BoxT box;
+  for (int k = 0; k < 3; k++) {
+    box.m_Min[k] = std::min({t[k], t[k + 3], t[k + 6]});
+    box.m_Max[k] = std::max({t[k], t[k + 3], t[k + 6]});
+  }
+  return box;
+}
+
+
+static inline void
+Grow(
+  BoxT& box,
+  const BoxT& other
+) {
+  for (int k = 0; k < 3; k++) {
+    box.m_Min[k] = std::min(box.m_Min[k], other.m_Min[k]);
+    box.m_Max[k] = std::max(box.m_Max[k], other.m_Max[k]);
+  }
+}
+
+
+static inline BoxT
+Empty() {
+  BoxT box;
+  for (int k = 0; k < 3; k++) {
+    box.m_Min[k] =  std::numeric_limits<float>::infinity();
+    box.m_Max[k] = -std::numeric_limits<float>::infinity();
+  }
+  return box;
+}
+
+
+static inline float
+Extent(
+  const BoxT& box
+) {
+  return (box.m_Max[0] - box.m_Min[0]) +
+         (box.m_Max[1] - box.m_Min[1]) +
+         (box.m_Max[2] - box.m_Min[2]);
+}
+
+
+bool
+Overlap(
+  const BoxT& a,
+  const BoxT& b
+) {
+  return a.m_Min[0] <= b.m_Max[0] && b.m_Min[0] <= a.m_Max[0] &&
+         a.m_Min[1] <= b.m_Max[1] && b.m_Min[1] <= a.m_Max[1] &&
+         a.m_Min[2] <= b.m_Max[2] && b.m_Min[2] <= a.m_Max[2];
+}
+
+
+Tree::Tree(
+  std::vector<Triangle> triangles,
+  std::vector<uint32_t> ids
+) {
+  size_t n = triangles.size();
+
+  std::vector<BoxT> boxes(n);
+  std::vector<std::array<float, 3>> centers(n);
+  for (size_t i = 0; i < n; i++) {
+    boxes[i] = TriangleBox(triangles[i]);
+    for (int k = 0; k < 3; k++) {
+      centers[i][k] = (boxes[i].m_Min[k] + boxes[i].m_Max[k]) * 0.5f;
+    }
+  }
+
+  std::vector<uint32_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
+
+  m_Nodes.reserve(std::max<size_t>(1, 2 * n / BVH_LEAF_SIZE + 1));
+  m_Nodes.push_back({Empty(), 0, 0});
+
+  struct Range { uint32_t node; uint32_t begin; uint32_t end; };
+  std::vector<Range> stack;
+  if (n > 0) {
+    stack.push_back({0, 0, uint32_t(n)});
+  }
+
+  while (!stack.empty()) {
+    auto range = stack.back();
+    stack.pop_back();
+
+    BoxT box = Empty();
+    BoxT centroid = Empty();
+    for (auto i = range.begin; i < range.end; i++) {
+      Grow(box, boxes[order[i]]);
+      BoxT point;
+      for (int k = 0; k < 3; k++) {
+        point.m_Min[k] = point.m_Max[k] = centers[order[i]][k];
+      }
+      Grow(centroid, point);
+    }
+
+    m_Nodes[range.node].m_Box = box;
+
+    if (range.end - range.begin <= BVH_LEAF_SIZE) {
+      m_Nodes[range.node].m_First = range.begin;
+      m_Nodes[range.node].m_Count = range.end - range.begin;
+      continue;
+    }
+
+    int axis = 0;
+    for (int k = 1; k < 3; k++) {
+      if (centroid.m_Max[k] - centroid.m_Min[k] >
+          centroid.m_Max[axis] - centroid.m_Min[axis]) {
+        axis = k;
+      }
+    }
+
+    auto middle = range.begin + (range.end - range.begin) / 2;
+    std::nth_element(
+      order.begin() + range.begin,
+      order.begin() + middle,
+      order.begin() + range.end,
+      [&](uint32_t a, uint32_t b) { return centers[a][axis] < centers[b][axis]; }
+    );
+
+    uint32_t left = m_Nodes.size();
+    m_Nodes.push_back({Empty(), 0, 0});
+    m_Nodes.push_back({Empty(), 0, 0});
+    m_Nodes[range.node].m_First = left;
+    m_Nodes[range.node].m_Count = 0;
+
+    stack.push_back({left, range.begin, middle});
+    stack.push_back({left + 1, middle, range.end});
+  }
+
+  m_Triangles.resize(n);
+  m_IDs.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    m_Triangles[i] = triangles[order[i]];
+    m_IDs[i] = ids[order[i]];
+  }
+}
+
+
+const BoxT&
+Tree::Bounds() const {
+  return m_Nodes[0].m_Box;
+}
+
+
+void
+Tree::Overlaps(
+  const Tree& other,
+  const std::function<void(uint32_t, uint32_t)>& visit
+) const {
+  std::vector<std::pair<uint32_t, uint32_t>> stack {{0, 0}};
+
+  while (!stack.empty()) {
+    auto [a, b] = stack.back();
+    stack.pop_back();
+
+    const auto& nodeA = m_Nodes[a];
+    const auto& nodeB = other.m_Nodes[b];
+    if (!Overlap(nodeA.m_Box, nodeB.m_Box)) {
+      continue;
+    }
+
+    if (nodeA.m_Count && nodeB.m_Count) {
+      for (auto i = nodeA.m_First; i < nodeA.m_First + nodeA.m_Count; i++) {
+        auto boxI = TriangleBox(m_Triangles[i]);
+        for (auto j = nodeB.m_First; j < nodeB.m_First + nodeB.m_Count; j++) {
+          if (Overlap(boxI, TriangleBox(other.m_Triangles[j]))) {
+            visit(i, j);
+          }
+        }
+      }
+    } else if (nodeB.m_Count ||
+               (!nodeA.m_Count && Extent(nodeA.m_Box) > Extent(nodeB.m_Box))) {
+      stack.push_back({nodeA.m_First, b});
+      stack.push_back({nodeA.m_First + 1, b});
+    } else {
+      stack.push_back({a, nodeB.m_First});
+      stack.push_back({a, nodeB.m_First + 1});
+    }
+  }
+}
+
+
+void
+Tree::Overlaps(
+  const std::function<void(uint32_t, uint32_t)>& visit
+) const {
+  std::vector<std::pair<uint32_t, uint32_t>> stack {{0, 0}};
+
+  while (!stack.empty()) {
+    auto [a, b] = stack.back();
+    stack.pop_back();
+
+    const auto& nodeA = m_Nodes[a];
+    const auto& nodeB = m_Nodes[b];
+
+    if (a == b) {
+      if (nodeA.m_Count) {
+        auto end = nodeA.m_First + nodeA.m_Count;
+        for (auto i = nodeA.m_First; i < end; i++) {
+          auto boxI = TriangleBox(m_Triangles[i]);
+          for (auto j = i + 1; j < end; j++) {
+            if (Overlap(boxI, TriangleBox(m_Triangles[j]))) {
+              visit(i, j);
+            }
+          }
+        }
+      } else {
+        stack.push_back({nodeA.m_First, nodeA.m_First});
+        stack.push_back({nodeA.m_First + 1, nodeA.m_First + 1});
+        stack.push_back({nodeA.m_First, nodeA.m_First + 1});
+      }
+      continue;
+    }
+
+    if (!Overlap(nodeA.m_Box, nodeB.m_Box)) {
+      continue;
+    }
+
+    if (nodeA.m_Count && nodeB.m_Count) {
+      for (auto i = nodeA.m_First; i < nodeA.m_First + nodeA.m_Count; i++) {
+        auto boxI = TriangleBox(m_Triangles[i]);
+        for (auto j = nodeB.m_First; j < nodeB.m_First + nodeB.m_Count; j++) {
+          if (Overlap(boxI, TriangleBox(m_Triangles[j]))) {
+            visit(i, j);
+          }
+        }
+      }
+    } else if (nodeB.m_Count ||
+               (!nodeA.m_Count && Extent(nodeA.m_Box) > Extent(nodeB.m_Box))) {
+      stack.push_back({nodeA.m_First, b});
+      stack.push_back({nodeA.m_First + 1, b});
+    } else {
+      stack.push_back({a, nodeB.m_First});
+      stack.push_back({a, nodeB.m_First + 1});
+    }
+  }
+}
+
+
+using Vec = std::array<double, 3>;
+
+
+static inline Vec
+Sub(const Vec& a, const Vec& b) {
+  return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+
+static inline Vec
+Cross(const Vec& a, const Vec& b) {
+  return {a[1] * b[2] - a[2] * b[1],
+          a[2] * b[0] - a[0] * b[2],
+          a[0] * b[1] - a[1] * b[0]};
+}
+
+
+static inline double
+Dot(const Vec& a, const Vec& b) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+
+// Signed area test of point p against directed edge a->b, in 2D.
+static inline double
+Orient2D(
+  const double (&a)[2],
+  const double (&b)[2],
+  const double (&p)[2]
+) {
+  return (b[0] - a[0]) * (p[1] - a[1]) - (b[1] - a[1]) * (p[0] - a[0]);
+}
+
+
+static bool
+SegmentsIntersect2D(
+  const double (&a)[2],
+  const double (&b)[2],
+  const double (&c)[2],
+  const double (&d)[2]
+) {
+  double d1 = Orient2D(c, d, a);
+  double d2 = Orient2D(c, d, b);
+  double d3 = Orient2D(a, b, c);
+  double d4 = Orient2D(a, b, d);
+
+  if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) &&
+      ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) {
+    return true;
+  }
+
+  auto on = [](const double (&p)[2], const double (&q)[2], const double (&r)[2]) {
+    return std::min(p[0], q[0]) <= r[0] && r[0] <= std::max(p[0], q[0]) &&
+           std::min(p[1], q[1]) <= r[1] && r[1] <= std::max(p[1], q[1]);
+  };
+
+  return (d1 == 0 && on(c, d, a)) || (d2 == 0 && on(c, d, b)) ||
+         (d3 == 0 && on(a, b, c)) || (d4 == 0 && on(a, b, d));
+}
+
+
+static bool
+PointInTriangle2D(
+  const double (&p)[2],
+  const double (&a)[2],
+  const double (&b)[2],
+  const double (&c)[2]
+) {
+  double d1 = Orient2D(a, b, p);
+  double d2 = Orient2D(b, c, p);
+  double d3 = Orient2D(c, a, p);
+  bool negative = d1 < 0 || d2 < 0 || d3 < 0;
+  bool positive = d1 > 0 || d2 > 0 || d3 > 0;
+  return !(negative && positive);
+}
+
+
+static bool
+Coplanar(
+  const Vec& normal,
+  const Vec (&v)[3],
+  const Vec (&u)[3]
+) {
+  // Project onto the plane where the normal's largest component is dropped.
+  int drop = 0;
+  for (int k = 1; k < 3; k++) {
+    if (std::fabs(normal[k]) > std::fabs(normal[drop])) {
+      drop = k;
+    }
+  }
+  int i0 = (drop + 1) % 3;
+  int i1 = (drop + 2) % 3;
+
+  double a[3][2], b[3][2];
+  for (int k = 0; k < 3; k++) {
+    a[k][0] = v[k][i0]; a[k][1] = v[k][i1];
+    b[k][0] = u[k][i0]; b[k][1] = u[k][i1];
+  }
+
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      if (SegmentsIntersect2D(a[i], a[(i + 1) % 3], b[j], b[(j + 1) % 3])) {
+        return true;
+      }
+    }
+  }
+
+  return PointInTriangle2D(a[0], b[0], b[1], b[2]) ||
+         PointInTriangle2D(b[0], a[0], a[1], a[2]);
+}
+
+
+// Interval of the triangle's intersection with the line of intersection of
+// both planes, given the projections p and plane distances d of its vertices.
+static bool
+Interval(
+  const double (&p)[3],
+  const double (&d)[3],
+  double (&isect)[2]
+) {
+  auto isect2 = [&](int i0, int i1, int i2) {
+    isect[0] = p[i0] + (p[i1] - p[i0]) * d[i0] / (d[i0] - d[i1]);
+    isect[1] = p[i0] + (p[i2] - p[i0]) * d[i0] / (d[i0] - d[i2]);
+  };
+
+  if (d[0] * d[1] > 0) {
+    isect2(2, 0, 1);
+  } else if (d[0] * d[2] > 0) {
+    isect2(1, 0, 2);
+  } else if (d[1] * d[2] > 0 || d[0] != 0) {
+    isect2(0, 1, 2);
+  } else if (d[1] != 0) {
+    isect2(1, 0, 2);
+  } else if (d[2] != 0) {
+    isect2(2, 0, 1);
+  } else {
+    return false;
+  }
+
+  if (isect[0] > isect[1]) {
+    std::swap(isect[0], isect[1]);
+  }
+  return true;
+}
+
+
+bool
+Intersect(
+  const Triangle& a,
+  const Triangle& b
+) {
+  Vec v[3], u[3];
+  for (int k = 0; k < 3; k++) {
+    v[k] = {a[3 * k], a[3 * k + 1], a[3 * k + 2]};
+    u[k] = {b[3 * k], b[3 * k + 1], b[3 * k + 2]};
+  }
+
+  // Distances of u from the plane of v, snapped to zero relative to scale.
+  Vec n1 = Cross(Sub(v[1], v[0]), Sub(v[2], v[0]));
+  double d1 = -Dot(n1, v[0]);
+  double du[3];
+  double scale1 = std::sqrt(Dot(n1, n1)) * 1e-9;
+  for (int k = 0; k < 3; k++) {
+    du[k] = Dot(n1, u[k]) + d1;
+    double extent = std::fabs(u[k][0]) + std::fabs(u[k][1]) + std::fabs(u[k][2]) + 1;
+    if (std::fabs(du[k]) <= scale1 * extent) {
+      du[k] = 0;
+    }
+  }
+
+  if ((du[0] > 0 && du[1] > 0 && du[2] > 0) ||
+      (du[0] < 0 && du[1] < 0 && du[2] < 0)) {
+    return false;
+  }
+
+  Vec n2 = Cross(Sub(u[1], u[0]), Sub(u[2], u[0]));
+  double d2 = -Dot(n2, u[0]);
+  double dv[3];
+  double scale2 = std::sqrt(Dot(n2, n2)) * 1e-9;
+  for (int k = 0; k < 3; k++) {
+    dv[k] = Dot(n2, v[k]) + d2;
+    double extent = std::fabs(v[k][0]) + std::fabs(v[k][1]) + std::fabs(v[k][2]) + 1;
+    if (std::fabs(dv[k]) <= scale2 * extent) {
+      dv[k] = 0;
+    }
+  }
+
+  if ((dv[0] > 0 && dv[1] > 0 && dv[2] > 0) ||
+      (dv[0] < 0 && dv[1] < 0 && dv[2] < 0)) {
+    return false;
+  }
+
+  if (du[0] == 0 && du[1] == 0 && du[2] == 0) {
+    return Coplanar(n1, v, u);
+  }
+
+  // Project both triangles onto the intersection line of the two planes.
+  Vec direction = Cross(n1, n2);
+  int axis = 0;
+  for (int k = 1; k < 3; k++) {
+    if (std::fabs(direction[k]) > std::fabs(direction[axis])) {
+      axis = k;
+    }
+  }
+
+  double pv[3] = {v[0][axis], v[1][axis], v[2][axis]};
+  double pu[3] = {u[0][axis], u[1][axis], u[2][axis]};
+
+  double iv[2], iu[2];
+  if (!Interval(pv, dv, iv) || !Interval(pu, du, iu)) {
+    return Coplanar(n1, v, u);
+  }
+
+  return !(iv[1] < iu[0] || iu[1] < iv[0]);
+}
+
+
+// Closest point on triangle t to p (Ericson, Real-Time Collision Detection
+// 5.1.5), as a squared distance.  Single precision is enough here: the
+// answer is a distance, not a predicate.
+static float
+PointTriangle(
+  const float (&p)[3],
+  const Triangle& t
+) {
+  float ab[3], ac[3], ap[3], bp[3], cp[3];
+  for (int k = 0; k < 3; k++) {
+    ab[k] = t[3 + k] - t[k];
+    ac[k] = t[6 + k] - t[k];
+    ap[k] = p[k] - t[k];
+    bp[k] = p[k] - t[3 + k];
+    cp[k] = p[k] - t[6 + k];
+  }
+  auto dot = [](const float (&a)[3], const float (&b)[3]) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  };
+  float d1 = dot(ab, ap), d2 = dot(ac, ap);
+  float d3 = dot(ab, bp), d4 = dot(ac, bp);
+  float d5 = dot(ab, cp), d6 = dot(ac, cp);
+  float va = d3 * d6 - d5 * d4, vb = d5 * d2 - d1 * d6, vc = d1 * d4 - d3 * d2;
+
+  // Barycentric weights of the closest point on b and c.
+  float v, w;
+  if (d1 <= 0 && d2 <= 0) {
+    v = 0, w = 0;
+  } else if (d3 >= 0 && d4 <= d3) {
+    v = 1, w = 0;
+  } else if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+    v = d1 / (d1 - d3), w = 0;
+  } else if (d6 >= 0 && d5 <= d6) {
+    v = 0, w = 1;
+  } else if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+    v = 0, w = d2 / (d2 - d6);
+  } else if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+    w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+    v = 1 - w;
+  } else {
+    float denom = 1 / (va + vb + vc);
+    v = vb * denom, w = vc * denom;
+  }
+
+  float d = 0;
+  for (int k = 0; k < 3; k++) {
+    float e = ap[k] - ab[k] * v - ac[k] * w;
+    d += e * e;
+  }
+  return d;
+}
+
+
+static inline double
+BoxDistance(
+  const BoxT& box,
+  const float (&p)[3]
+) {
+  double d = 0;
+  for (int k = 0; k < 3; k++) {
+    double e = std::max({double(box.m_Min[k]) - p[k], double(p[k]) - box.m_Max[k], 0.0});
+    d += e * e;
+  }
+  return d;
+}
+
+
+double
+Tree::Nearest(
+  const float (&p)[3]
+) const {
+  double best = std::numeric_limits<double>::infinity();
+  if (m_Triangles.empty()) {
+    return best;
+  }
+
+  std::pair<uint32_t, double> stack[BVH_STACK];
+  int top = 0;
+  stack[top++] = {0, BoxDistance(m_Nodes[0].m_Box, p)};
+
+  while (top) {
+    auto [n, distance] = stack[--top];
+    if (distance >= best) {
+      continue;
+    }
+
+    const auto& node = m_Nodes[n];
+    if (node.m_Count) {
+      for (auto i = node.m_First; i < node.m_First + node.m_Count; i++) {
+        best = std::min(best, double(PointTriangle(p, m_Triangles[i])));
+      }
+      continue;
+    }
+
+    double left = BoxDistance(m_Nodes[node.m_First].m_Box, p);
+    double right = BoxDistance(m_Nodes[node.m_First + 1].m_Box, p);
+    if (left < right) {
+      stack[top++] = {node.m_First + 1, right};
+      stack[top++] = {node.m_First, left};
+    } else {
+      stack[top++] = {node.m_First, left};
+      stack[top++] = {node.m_First + 1, right};
+    }
+  }
+
+  return best;
+}
+
+
+// Sign of the edge function of a->b, (dy, dz) = b - a in the YZ plane.  A
+// zero takes the sign it would have at p + (0, e, e^2) for a vanishing e, so
+// a ray through an edge or vertex hits exactly the triangles that contain the
+// perturbed point, whichever way they face.
+static inline int
+EdgeSign(
+  double e,
+  double dy,
+  double dz
+) {
+  if (e != 0) {
+    return e > 0 ? 1 : -1;
+  }
+  if (dz != 0) {
+    return dz < 0 ? 1 : -1;
+  }
+  return dy > 0 ? 1 : -1;
+}
+
+
+// Whether the ray from p towards +X crosses t.  Edge functions are taken in
+// the YZ plane relative to p, so reversing an edge negates them exactly.
+static bool
+Crosses(
+  const Triangle& t,
+  const float (&p)[3]
+) {
+  double ay = double(t[1]) - p[1], az = double(t[2]) - p[2];
+  double by = double(t[4]) - p[1], bz = double(t[5]) - p[2];
+  double cy = double(t[7]) - p[1], cz = double(t[8]) - p[2];
+
+  double u = by * cz - bz * cy;
+  double v = cy * az - cz * ay;
+  double w = ay * bz - az * by;
+  int su = EdgeSign(u, cy - by, cz - bz);
+  int sv = EdgeSign(v, ay - cy, az - cz);
+  int sw = EdgeSign(w, by - ay, bz - az);
+  double det = u + v + w;
+  if (su != sv || sv != sw || det == 0) {
+    return false;
+  }
+
+  double x = u * (double(t[0]) - p[0]) + v * (double(t[3]) - p[0]) + w * (double(t[6]) - p[0]);
+  return det > 0 ? x > 0 : x < 0;
+}
+
+
+bool
+Tree::Inside(
+  const float (&p)[3]
+) const {
+  if (m_Triangles.empty()) {
+    return false;
+  }
+
+  bool inside = false;
+  uint32_t stack[BVH_STACK];
+  int top = 0;
+  stack[top++] = 0;
+
+  while (top) {
+    const auto& node = m_Nodes[stack[--top]];
+    const auto& box = node.m_Box;
+    if (box.m_Max[0] < p[0] || box.m_Min[1] > p[1] || box.m_Max[1] < p[1] ||
+        box.m_Min[2] > p[2] || box.m_Max[2] < p[2]) {
+      continue;
+    }
+
+    if (node.m_Count) {
+      for (auto i = node.m_First; i < node.m_First + node.m_Count; i++) {
+        inside ^= Crosses(m_Triangles[i], p);
+      }
+    } else {
+      stack[top++] = node.m_First;
+      stack[top++] = node.m_First + 1;
+    }
+  }
+
+  return inside;
+}
+
+
+} /* namespace BVHSTL */
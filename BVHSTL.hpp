@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+namespace BVHSTL {
+
+
+// Three vertices, x,y,z each.
+using Triangle = std::array<float, 9>;
+
+
+typedef struct
+Box {
+  float m_Min[3];
+  float m_Max[3];
+} BoxT;
+
+
+typedef struct
+Node {
+  BoxT      m_Box;
+  uint32_t  m_First;   // first triangle (leaf) or left child (interior)
+  uint32_t  m_Count;   // triangle count, zero for interior nodes
+} NodeT;
+
+
+class Tree {
+public:
+  // Build over triangles, which are reordered into leaf order; m_IDs maps
+  // each position back to the id supplied by the caller.
+  Tree(
+    std::vector<Triangle> triangles,
+    std::vector<uint32_t> ids
+  );
+
+  const BoxT&
+  Bounds() const;
+
+  // Call visit(a, b) with the positions of every triangle pair, one from each
+  // tree, whose bounding boxes overlap.
+  void
+  Overlaps(
+    const Tree& other,
+    const std::function<void(uint32_t, uint32_t)>& visit
+  ) const;
+
+  // As above for distinct triangle pairs within this tree, each pair once.
+  void
+  Overlaps(
+    const std::function<void(uint32_t, uint32_t)>& visit
+  ) const;
+
+  // Squared distance from p to the nearest triangle, visiting nearer
+  // children first and skipping boxes farther than the best so far.
+  double
+  Nearest(
+    const float (&p)[3]
+  ) const;
+
+  // Whether p lies inside the closed surface: the parity of the triangles
+  // crossed by a ray from p towards +X.  Edges and vertices the ray passes
+  // through are counted for exactly one of the triangles sharing them.
+  bool
+  Inside(
+    const float (&p)[3]
+  ) const;
+
+  std::vector<NodeT>    m_Nodes;
+  std::vector<Triangle> m_Triangles;
+  std::vector<uint32_t> m_IDs;
+};
+
+
+bool
+Overlap(
+  const BoxT& a,
+  const BoxT& b
+);
+
+
+// Triangle/triangle intersection (Moller), evaluated in double precision and
+// including the coplanar case.
+bool
+Intersect(
+  const Triangle& a,
+  const Triangle& b
+);
+
+
+} /* namespace BVHSTL */
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <utility>
+#include <sys/mman.h>
+
+#define BUFFER_ALIGNMENT       64
+#define BUFFER_HUGE_ALIGNMENT  (2 << 20)
+
+namespace BufferSTL {
+
+
+// Byte storage for facets.  Unlike std::vector<char>, Resize leaves new
+// bytes uninitialized, so reading a file into it touches every page once.
+// Storage is cache line aligned, and from 2MB up it is 2MB aligned and
+// advised for transparent huge pages.
+class Buffer {
+public:
+  Buffer() = default;
+
+  Buffer(const Buffer &other) {
+    Resize(other.m_Size);
+    if (m_Size) {
+      std::memcpy(m_Data, other.m_Data, m_Size);
+    }
+  }
+
+  Buffer(Buffer &&other) noexcept {
+    Swap(other);
+  }
+
+  Buffer &
+  operator=(Buffer other) noexcept {
+    Swap(other);
+    return *this;
+  }
+
+  ~Buffer() {
+    std::free(m_Data);
+  }
+
+
+  char &
+  operator[](size_t i) {
+    return m_Data[i];
+  }
+
+  const char &
+  operator[](size_t i) const {
+    return m_Data[i];
+  }
+
+  char *
+  Data() {
+    return m_Data;
+  }
+
+  size_t
+  Size() const {
+    return m_Size;
+  }
+
+  size_t
+  Capacity() const {
+    return m_Capacity;
+  }
+
+
+  // Grow capacity to at least bytes, keeping the contents.
+  void
+  Reserve(
+    size_t bytes
+  ) {
+    if (bytes <= m_Capacity) {
+      return;
+    }
+
+    size_t alignment = bytes >= BUFFER_HUGE_ALIGNMENT ? BUFFER_HUGE_ALIGNMENT
+                                                      : BUFFER_ALIGNMENT;
+    size_t capacity = (bytes + alignment - 1) / alignment * alignment;
+    char *data = static_cast<char *>(std::aligned_alloc(alignment, capacity));
+    if (!data) {
+      throw std::bad_alloc();
+    }
+    if (alignment == BUFFER_HUGE_ALIGNMENT) {
+      madvise(data, capacity, MADV_HUGEPAGE);
+    }
+
+    if (m_Size) {
+      std::memcpy(data, m_Data, m_Size);
+    }
+    std::free(m_Data);
+    m_Data = data;
+    m_Capacity = capacity;
+  }
+
+
+  // Set the size; bytes past the old size are uninitialized.
+  void
+  Resize(
+    size_t bytes
+  ) {
+    Reserve(bytes);
+    m_Size = bytes;
+  }
+
+
+  void
+  Swap(
+    Buffer &other
+  ) noexcept {
+    std::swap(m_Data, other.m_Data);
+    std::swap(m_Size, other.m_Size);
+    std::swap(m_Capacity, other.m_Capacity);
+  }
+
+
+private:
+  char   *m_Data = nullptr;
+  size_t  m_Size = 0;
+  size_t  m_Capacity = 0;
+};
+
+
+} /* namespace BufferSTL */
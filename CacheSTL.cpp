@@ -0,0 +1,207 @@
+#include "CacheSTL.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "ParallelSTL.hpp"
+
+#define CACHE_CHUNK_SIZE (1 << 20)
+#define CACHE_MAGIC      0x54504f54u   // "TOPT"
+#define CACHE_VERSION    1
+
+
+namespace CacheSTL {
+
+
+#pragma pack(push, 1)
+  typedef struct
+  CacheHeader {
+    uint32_t  m_Magic;
+    uint32_t  m_Version;
+    uint64_t  m_Hash;
+    uint64_t  m_Facets;
+  } CacheHeaderT;
+#pragma pack(pop)
+
+
+static inline uint64_t
+Mix(
+  uint64_t h
+) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+
+static uint64_t
+HashChunk(
+  const unsigned char* data,
+  size_t length,
+  uint64_t seed
+) {
+  // Four independent lanes keep the multiplies pipelined.
+  uint64_t lane[4] = {
+    seed ^ 0x9e3779b97f4a7c15ULL, seed ^ 0xbf58476d1ce4e5b9ULL,
+    seed ^ 0x94d049bb133111ebULL, seed ^ 0x2545f4914f6cdd1dULL
+  };
+
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    for (int k = 0; k < 4; k++) {
+      uint64_t word;
+      std::memcpy(&word, data + i + 8 * k, sizeof(word));
+      lane[k] = (lane[k] ^ word) * 0x9fb21c651e98df25ULL;
+      lane[k] ^= lane[k] >> 29;
+    }
+  }
+
+  uint64_t h = Mix(lane[0]) ^ Mix(lane[1] + 1) ^ Mix(lane[2] + 2) ^ Mix(lane[3] + 3);
+  for (; i < length; i += 8) {
+    uint64_t word = 0;
+    std::memcpy(&word, data + i, std::min<size_t>(length - i, 8));
+    h = Mix(h ^ word);
+  }
+
+  return Mix(h ^ length);
+}
+
+
+uint64_t
+Hash(
+  const void* data,
+  size_t length,
+  int threads
+) {
+  auto bytes = static_cast<const unsigned char*>(data);
+  size_t chunks = (length + CACHE_CHUNK_SIZE - 1) / CACHE_CHUNK_SIZE;
+  std::vector<uint64_t> hashes(chunks);
+
+  ParallelSTL::For(threads, chunks, [&](size_t begin, size_t end, int) {
+    for (size_t c = begin; c < end; c++) {
+      size_t offset = c * CACHE_CHUNK_SIZE;
+      hashes[c] = HashChunk(bytes + offset,
+                            std::min<size_t>(CACHE_CHUNK_SIZE, length - offset), c);
+    }
+  }, 1);
+
+  uint64_t h = Mix(length);
+  for (auto chunk : hashes) {
+    h = Mix(h ^ chunk) + 0x9e3779b97f4a7c15ULL;
+  }
+  return h;
+}
+
+
+static std::string
+Filename(
+  const std::string& directory,
+  uint64_t hash
+) {
+  std::ostringstream name;
+  name << directory << "/" << std::hex << std::setw(16) << std::setfill('0')
+       << hash << ".topo";
+  return name.str();
+}
+
+
+bool
+Load(
+  const std::string& directory,
+  uint64_t hash,
+  size_t facets,
+  std::vector<uint32_t>& labels,
+  std::vector<uint32_t>& weld
+) {
+  std::ifstream input{Filename(directory, hash), std::ios::binary | std::ios::in};
+  if (!input) {
+    return false;
+  }
+
+  CacheHeaderT header;
+  input.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!input || header.m_Magic != CACHE_MAGIC || header.m_Version != CACHE_VERSION ||
+      header.m_Hash != hash || header.m_Facets != facets) {
+    return false;
+  }
+
+  labels.resize(facets);
+  weld.resize(3 * facets);
+  input.read(reinterpret_cast<char*>(labels.data()), labels.size() * sizeof(uint32_t));
+  input.read(reinterpret_cast<char*>(weld.data()), weld.size() * sizeof(uint32_t));
+
+  return bool(input);
+}
+
+
+// mkdir -p: create directory and any missing parents.
+static bool
+Directories(
+  const std::string& directory
+) {
+  for (size_t slash = directory.find('/', 1); ; slash = directory.find('/', slash + 1)) {
+    auto path = directory.substr(0, slash);
+    if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+      return false;
+    }
+    if (slash == std::string::npos) {
+      break;
+    }
+  }
+
+  struct stat st;
+  return stat(directory.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+
+bool
+Store(
+  const std::string& directory,
+  uint64_t hash,
+  const std::vector<uint32_t>& labels,
+  const std::vector<uint32_t>& weld
+) {
+  if (!Directories(directory)) {
+    // Every store would fail the same way; say so once per process.
+    static std::atomic<bool> reported{false};
+    if (!reported.exchange(true)) {
+      std::cerr << "Cache ERROR: Unable to create " << directory << ": "
+                << std::strerror(errno) << std::endl;
+    }
+    return false;
+  }
+
+  auto filename = Filename(directory, hash);
+  std::ostringstream temporary;
+  temporary << filename << "." << getpid() << "." << std::this_thread::get_id();
+
+  CacheHeaderT header = {CACHE_MAGIC, CACHE_VERSION, hash, labels.size()};
+
+  std::ofstream output{temporary.str(), std::ios::binary | std::ios::out};
+  output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  output.write(reinterpret_cast<const char*>(labels.data()), labels.size() * sizeof(uint32_t));
+  output.write(reinterpret_cast<const char*>(weld.data()), weld.size() * sizeof(uint32_t));
+  output.close();
+
+  if (!output || rename(temporary.str().c_str(), filename.c_str()) != 0) {
+    unlink(temporary.str().c_str());
+    return false;
+  }
+
+  return true;
+}
+
+
+} /* namespace CacheSTL */
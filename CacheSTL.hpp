@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace CacheSTL {
+
+
+// 64 bit content hash of a buffer, computed over fixed size chunks in
+// parallel and combined in chunk order, so the result does not depend on the
+// number of threads.
+uint64_t
+Hash(
+  const void* data,
+  size_t length,
+  int threads
+);
+
+
+// Per-facet manifold object labels and per-vertex weld ids (three per facet)
+// stored under directory, keyed by hash.  Load returns false on any miss or
+// mismatch; Store is atomic with respect to concurrent readers.
+bool
+Load(
+  const std::string& directory,
+  uint64_t hash,
+  size_t facets,
+  std::vector<uint32_t>& labels,
+  std::vector<uint32_t>& weld
+);
+
+bool
+Store(
+  const std::string& directory,
+  uint64_t hash,
+  const std::vector<uint32_t>& labels,
+  const std::vector<uint32_t>& weld
+);
+
+
+} /* namespace CacheSTL */
@@ -0,0 +1,185 @@
+#include "CurveSTL.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#include "STLBIfc.hpp"
+#include "ParallelSTL.hpp"
+
+#define CURVE_BITS        21
+#define CURVE_RADIX_BITS  11
+#define CURVE_RADIX       (1 << CURVE_RADIX_BITS)
+
+
+namespace CurveSTL {
+
+
+// Spread the low 21 bits of v to every third bit.
+static inline uint64_t
+Spread(
+  uint32_t v
+) {
+  uint64_t x = v & 0x1fffff;
+  x = (x | x << 32) & 0x001f00000000ffffULL;
+  x = (x | x << 16) & 0x001f0000ff0000ffULL;
+  x = (x | x << 8)  & 0x100f00f00f00f00fULL;
+  x = (x | x << 4)  & 0x10c30c30c30c30c3ULL;
+  x = (x | x << 2)  & 0x1249249249249249ULL;
+  return x;
+}
+
+
+uint64_t
+Morton(
+  uint32_t x,
+  uint32_t y,
+  uint32_t z
+) {
+  return Spread(x) << 2 | Spread(y) << 1 | Spread(z);
+}
+
+
+// Skilling, "Programming the Hilbert curve" (2004): transpose the axes into
+// Hilbert order, after which interleaving the bits gives the index.
+uint64_t
+Hilbert(
+  uint32_t x,
+  uint32_t y,
+  uint32_t z
+) {
+  uint32_t X[3] = { x, y, z };
+  const uint32_t M = 1u << (CURVE_BITS - 1);
+
+  for (uint32_t Q = M; Q > 1; Q >>= 1) {
+    uint32_t P = Q - 1;
+    for (int i = 0; i < 3; i++) {
+      if (X[i] & Q) {
+        X[0] ^= P;
+      } else {
+        uint32_t t = (X[0] ^ X[i]) & P;
+        X[0] ^= t;
+        X[i] ^= t;
+      }
+    }
+  }
+
+  for (int i = 1; i < 3; i++) {
+    X[i] ^= X[i - 1];
+  }
+  uint32_t t = 0;
+  for (uint32_t Q = M; Q > 1; Q >>= 1) {
+    if (X[2] & Q) {
+      t ^= Q - 1;
+    }
+  }
+  for (int i = 0; i < 3; i++) {
+    X[i] ^= t;
+  }
+
+  return Morton(X[0], X[1], X[2]);
+}
+
+
+void
+Sort(
+  std::vector<uint64_t>& keys,
+  int threads,
+  std::vector<uint32_t>& order
+) {
+  size_t count = keys.size();
+  order.resize(count);
+  ParallelSTL::For(threads, count, [&](size_t begin, size_t end, int) {
+    for (size_t i = begin; i < end; i++) {
+      order[i] = i;
+    }
+  });
+
+  // LSD radix sort, 11 bits a pass.  Every worker histograms its own
+  // contiguous range, and scatters it after the same digit of the workers
+  // before it, which keeps the sort stable.
+  int nWorkers = ParallelSTL::Workers(threads, count);
+  std::vector<size_t> counts(size_t(nWorkers) * CURVE_RADIX);
+  std::vector<uint64_t> keysOut(count);
+  std::vector<uint32_t> orderOut(count);
+
+  for (int shift = 0; shift < 3 * CURVE_BITS; shift += CURVE_RADIX_BITS) {
+    std::fill(counts.begin(), counts.end(), 0);
+
+    ParallelSTL::For(threads, count, [&](size_t begin, size_t end, int thread) {
+      size_t* mine = &counts[size_t(thread) * CURVE_RADIX];
+      for (size_t i = begin; i < end; i++) {
+        mine[(keys[i] >> shift) & (CURVE_RADIX - 1)]++;
+      }
+    });
+
+    // A digit every key shares leaves the order as it is.
+    bool trivial = false;
+    size_t total = 0;
+    for (size_t d = 0; d < CURVE_RADIX; d++) {
+      size_t digit = 0;
+      for (int t = 0; t < nWorkers; t++) {
+        size_t n = counts[size_t(t) * CURVE_RADIX + d];
+        counts[size_t(t) * CURVE_RADIX + d] = total;
+        total += n;
+        digit += n;
+      }
+      trivial = trivial || digit == count;
+    }
+    if (trivial) {
+      continue;
+    }
+
+    ParallelSTL::For(threads, count, [&](size_t begin, size_t end, int thread) {
+      size_t* next = &counts[size_t(thread) * CURVE_RADIX];
+      for (size_t i = begin; i < end; i++) {
+        size_t slot = next[(keys[i] >> shift) & (CURVE_RADIX - 1)]++;
+        keysOut[slot] = keys[i];
+        orderOut[slot] = order[i];
+      }
+    });
+
+    keys.swap(keysOut);
+    order.swap(orderOut);
+  }
+}
+
+
+void
+Order(
+  const STLFacet* facets,
+  size_t count,
+  const float (&x)[2],
+  const float (&y)[2],
+  const float (&z)[2],
+  Curve curve,
+  int threads,
+  std::vector<uint32_t>& order
+) {
+  const float* bounds[3] = { x, y, z };
+  const float cells = float((1u << CURVE_BITS) - 1);
+  float scale[3];
+  for (int k = 0; k < 3; k++) {
+    float extent = bounds[k][1] - bounds[k][0];
+    scale[k] = extent > 0 ? cells / extent : 0;
+  }
+
+  std::vector<uint64_t> keys(count);
+
+  ParallelSTL::For(threads, count, [&](size_t begin, size_t end, int) {
+    for (size_t i = begin; i < end; i++) {
+      uint32_t cell[3];
+      for (int k = 0; k < 3; k++) {
+        float centroid = (facets[i].m_Vertex1[k] + facets[i].m_Vertex2[k] +
+                          facets[i].m_Vertex3[k]) / 3.0f;
+        cell[k] = uint32_t(std::clamp((centroid - bounds[k][0]) * scale[k], 0.0f, cells));
+      }
+      keys[i] = curve == Curve::Hilbert ? Hilbert(cell[0], cell[1], cell[2])
+                                        : Morton(cell[0], cell[1], cell[2]);
+    }
+  });
+
+  Sort(keys, threads, order);
+}
+
+
+} /* namespace CurveSTL */
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct STLFacet;
+
+namespace CurveSTL {
+
+
+enum class Curve { Morton, Hilbert };
+
+
+// 63 bit keys of 21 bit grid coordinates along a Z-order or Hilbert curve.
+uint64_t
+Morton(
+  uint32_t x,
+  uint32_t y,
+  uint32_t z
+);
+
+uint64_t
+Hilbert(
+  uint32_t x,
+  uint32_t y,
+  uint32_t z
+);
+
+
+// Indices of keys in ascending key order, by a stable parallel LSD radix
+// sort over the low 63 bits; keys are left in that order.
+void
+Sort(
+  std::vector<uint64_t>& keys,
+  int threads,
+  std::vector<uint32_t>& order
+);
+
+
+// Facet indices sorted along curve by facet centroid, quantized to a 2^21
+// grid over bounds.  Keys are computed in parallel and sorted as above, so
+// equal keys keep their input order.
+void
+Order(
+  const STLFacet* facets,
+  size_t count,
+  const float (&x)[2],
+  const float (&y)[2],
+  const float (&z)[2],
+  Curve curve,
+  int threads,
+  std::vector<uint32_t>& order
+);
+
+
+} /* namespace CurveSTL */
@@ -0,0 +1,805 @@
+#include "CutSTL.hpp"
+
+#include <cmath>
+#include <array>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+#include "STLBIfc.hpp"
+#include "CurveSTL.hpp"
+#include "ParallelSTL.hpp"
+
+#define CUT_HASH_NODES 80
+
+
+namespace CutSTL {
+
+
+using Point = std::array<float, 3>;
+
+
+// A cut edge, directed the way the upper cap runs along it.
+typedef struct
+Segment {
+  Point m_From;
+  Point m_To;
+} SegmentT;
+
+
+typedef struct
+Node {
+  double    m_X, m_Y;
+  uint32_t  m_Point;
+  uint32_t  m_Prev, m_Next;
+  uint64_t  m_Z;                // Z-order key, once the ring is indexed.
+  uint32_t  m_PrevZ, m_NextZ;
+} NodeT;
+
+
+struct PointHash {
+  size_t
+  operator()(const Point& p) const {
+    uint32_t bits[3];
+    std::memcpy(bits, p.data(), sizeof(bits));
+    return (uint64_t(bits[0]) * 0x9e3779b97f4a7c15ULL) ^
+           (uint64_t(bits[1]) * 0xc2b2ae3d27d4eb4fULL) ^
+           (uint64_t(bits[2]) * 0x165667b19e3779f9ULL);
+  }
+};
+
+
+// Twice the signed area of p, q, r, negative when they turn counter-clockwise;
+// the sign convention and the hole bridging below follow earcut.
+static inline double
+Area(
+  const NodeT& p,
+  const NodeT& q,
+  const NodeT& r
+) {
+  return (q.m_Y - p.m_Y) * (r.m_X - q.m_X) - (q.m_X - p.m_X) * (r.m_Y - q.m_Y);
+}
+
+
+static inline bool
+InTriangle(
+  double ax, double ay,
+  double bx, double by,
+  double cx, double cy,
+  double px, double py
+) {
+  return (cx - px) * (ay - py) >= (ax - px) * (cy - py) &&
+         (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+         (bx - px) * (cy - py) >= (cx - px) * (by - py);
+}
+
+
+static inline bool
+Same(
+  const NodeT& a,
+  const NodeT& b
+) {
+  return a.m_X == b.m_X && a.m_Y == b.m_Y;
+}
+
+
+// Ear clipping of one counter-clockwise outer loop and its clockwise holes,
+// which are first bridged into the outer loop.  Rings over CUT_HASH_NODES
+// vertices are also linked in Z-order, so an ear test only visits vertices
+// inside the ear's bounding box, as in earcut.  Triangles come out counter-
+// clockwise as point triples.
+class Triangulator {
+public:
+  Triangulator(
+    const std::vector<std::array<double, 2>>& plane
+  ) : m_Plane(plane) {}
+
+
+  void
+  Run(
+    const std::vector<uint32_t>& outer,
+    const std::vector<const std::vector<uint32_t>*>& holes,
+    std::vector<uint32_t>& triangles
+  ) {
+    m_Nodes.clear();
+    uint32_t start = Ring(outer);
+
+    std::vector<uint32_t> lefts;
+    for (auto hole : holes) {
+      uint32_t first = Ring(*hole), left = first;
+      for (uint32_t p = m_Nodes[first].m_Next; p != first; p = m_Nodes[p].m_Next) {
+        if (m_Nodes[p].m_X < m_Nodes[left].m_X ||
+            (m_Nodes[p].m_X == m_Nodes[left].m_X && m_Nodes[p].m_Y < m_Nodes[left].m_Y)) {
+          left = p;
+        }
+      }
+      lefts.push_back(left);
+    }
+    std::sort(lefts.begin(), lefts.end(), [&](uint32_t a, uint32_t b) {
+      return m_Nodes[a].m_X < m_Nodes[b].m_X;
+    });
+    for (auto left : lefts) {
+      uint32_t bridge = Bridge(left, start);
+      if (bridge != UINT32_MAX) {
+        Split(bridge, left);
+      }
+    }
+
+    Clip(start, triangles);
+  }
+
+
+private:
+  uint32_t
+  Ring(
+    const std::vector<uint32_t>& loop
+  ) {
+    uint32_t first = m_Nodes.size();
+    for (size_t i = 0; i < loop.size(); i++) {
+      uint32_t n = m_Nodes.size();
+      m_Nodes.push_back({
+        m_Plane[loop[i]][0], m_Plane[loop[i]][1], loop[i],
+        i ? n - 1 : uint32_t(first + loop.size() - 1),
+        i + 1 < loop.size() ? n + 1 : first
+      });
+    }
+    return first;
+  }
+
+
+  bool
+  LocallyInside(
+    uint32_t a,
+    uint32_t b
+  ) {
+    const NodeT& A = m_Nodes[a];
+    const NodeT& prev = m_Nodes[A.m_Prev];
+    const NodeT& next = m_Nodes[A.m_Next];
+    const NodeT& B = m_Nodes[b];
+    return Area(prev, A, next) < 0 ? Area(A, B, next) >= 0 && Area(A, prev, B) >= 0
+                                   : Area(A, B, prev) < 0 || Area(A, next, B) < 0;
+  }
+
+
+  // The outer vertex a hole's leftmost vertex can see: cast a ray to -x,
+  // take the nearest edge it hits, then the vertex closest to the ray inside
+  // the triangle to that edge.
+  uint32_t
+  Bridge(
+    uint32_t hole,
+    uint32_t outer
+  ) {
+    double hx = m_Nodes[hole].m_X, hy = m_Nodes[hole].m_Y;
+    double qx = -HUGE_VAL;
+    uint32_t m = UINT32_MAX;
+
+    uint32_t p = outer;
+    do {
+      const NodeT& P = m_Nodes[p];
+      const NodeT& N = m_Nodes[P.m_Next];
+      if (hy <= P.m_Y && hy >= N.m_Y && N.m_Y != P.m_Y) {
+        double x = P.m_X + (hy - P.m_Y) * (N.m_X - P.m_X) / (N.m_Y - P.m_Y);
+        if (x <= hx && x > qx) {
+          qx = x;
+          m = P.m_X < N.m_X ? p : P.m_Next;
+          if (x == hx) {
+            return m;
+          }
+        }
+      }
+      p = P.m_Next;
+    } while (p != outer);
+
+    if (m == UINT32_MAX) {
+      return m;
+    }
+
+    uint32_t stop = m;
+    double mx = m_Nodes[m].m_X, my = m_Nodes[m].m_Y, tanMin = HUGE_VAL;
+    p = m;
+    do {
+      const NodeT& P = m_Nodes[p];
+      if (hx >= P.m_X && P.m_X >= mx && hx != P.m_X &&
+          InTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, P.m_X, P.m_Y)) {
+        double tan = std::fabs(hy - P.m_Y) / (hx - P.m_X);
+        if (LocallyInside(p, hole) && (tan < tanMin || (tan == tanMin && P.m_X > m_Nodes[m].m_X))) {
+          m = p;
+          tanMin = tan;
+        }
+      }
+      p = P.m_Next;
+    } while (p != stop);
+
+    return m;
+  }
+
+
+  // Join the hole at b to the outer loop at a, duplicating both so the ring
+  // runs a, b, around the hole, b', a', on around the outer loop.
+  void
+  Split(
+    uint32_t a,
+    uint32_t b
+  ) {
+    uint32_t a2 = m_Nodes.size(), b2 = a2 + 1;
+    m_Nodes.push_back(m_Nodes[a]);
+    m_Nodes.push_back(m_Nodes[b]);
+    uint32_t an = m_Nodes[a].m_Next, bp = m_Nodes[b].m_Prev;
+
+    m_Nodes[a].m_Next = b;
+    m_Nodes[b].m_Prev = a;
+    m_Nodes[a2].m_Next = an;
+    m_Nodes[an].m_Prev = a2;
+    m_Nodes[b2].m_Next = a2;
+    m_Nodes[a2].m_Prev = b2;
+    m_Nodes[bp].m_Next = b2;
+    m_Nodes[b2].m_Prev = bp;
+  }
+
+
+  // Z-order key on a 2^21 grid over the ring's bounds.
+  uint64_t
+  Key(
+    double x,
+    double y
+  ) {
+    return CurveSTL::Morton(uint32_t((x - m_MinX) * m_Scale), uint32_t((y - m_MinY) * m_Scale), 0);
+  }
+
+
+  // Link the ring starting at start in Z-order, by radix sort of the keys.
+  void
+  Index(
+    uint32_t start
+  ) {
+    std::vector<uint32_t> ring;
+    m_MinX = m_MinY = HUGE_VAL;
+    double maxX = -HUGE_VAL, maxY = -HUGE_VAL;
+    uint32_t p = start;
+    do {
+      ring.push_back(p);
+      m_MinX = std::min(m_MinX, m_Nodes[p].m_X);
+      m_MinY = std::min(m_MinY, m_Nodes[p].m_Y);
+      maxX = std::max(maxX, m_Nodes[p].m_X);
+      maxY = std::max(maxY, m_Nodes[p].m_Y);
+      p = m_Nodes[p].m_Next;
+    } while (p != start);
+
+    m_Hashed = ring.size() > CUT_HASH_NODES;
+    if (!m_Hashed) {
+      return;
+    }
+
+    double size = std::max(maxX - m_MinX, maxY - m_MinY);
+    m_Scale = size > 0 ? ((1 << 21) - 1) / size : 0;
+
+    std::vector<uint64_t> keys(ring.size());
+    for (size_t i = 0; i < ring.size(); i++) {
+      keys[i] = m_Nodes[ring[i]].m_Z = Key(m_Nodes[ring[i]].m_X, m_Nodes[ring[i]].m_Y);
+    }
+
+    std::vector<uint32_t> order;
+    CurveSTL::Sort(keys, 1, order);
+
+    for (size_t i = 0; i < order.size(); i++) {
+      NodeT& node = m_Nodes[ring[order[i]]];
+      node.m_PrevZ = i ? ring[order[i - 1]] : UINT32_MAX;
+      node.m_NextZ = i + 1 < order.size() ? ring[order[i + 1]] : UINT32_MAX;
+    }
+  }
+
+
+  // Whether P, a vertex other than the ear's own, blocks the ear a, b, c.
+  bool
+  Blocks(
+    const NodeT& a,
+    const NodeT& b,
+    const NodeT& c,
+    const NodeT& P
+  ) {
+    return InTriangle(a.m_X, a.m_Y, b.m_X, b.m_Y, c.m_X, c.m_Y, P.m_X, P.m_Y) &&
+           !Same(P, a) && !Same(P, b) && !Same(P, c) &&
+           Area(m_Nodes[P.m_Prev], P, m_Nodes[P.m_Next]) >= 0;
+  }
+
+
+  bool
+  Ear(
+    uint32_t ear
+  ) {
+    uint32_t prev = m_Nodes[ear].m_Prev, next = m_Nodes[ear].m_Next;
+    const NodeT& a = m_Nodes[prev];
+    const NodeT& b = m_Nodes[ear];
+    const NodeT& c = m_Nodes[next];
+    if (Area(a, b, c) >= 0) {
+      return false;
+    }
+
+    if (!m_Hashed) {
+      for (uint32_t p = c.m_Next; p != prev; p = m_Nodes[p].m_Next) {
+        if (Blocks(a, b, c, m_Nodes[p])) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // Only vertices with keys between the corners of the ear's bounding box
+    // can lie inside it; walk out from the ear in both Z directions.
+    uint64_t minZ = Key(std::min({ a.m_X, b.m_X, c.m_X }), std::min({ a.m_Y, b.m_Y, c.m_Y }));
+    uint64_t maxZ = Key(std::max({ a.m_X, b.m_X, c.m_X }), std::max({ a.m_Y, b.m_Y, c.m_Y }));
+
+    for (uint32_t p = b.m_NextZ; p != UINT32_MAX && m_Nodes[p].m_Z <= maxZ; p = m_Nodes[p].m_NextZ) {
+      if (p != prev && p != next && Blocks(a, b, c, m_Nodes[p])) {
+        return false;
+      }
+    }
+    for (uint32_t p = b.m_PrevZ; p != UINT32_MAX && m_Nodes[p].m_Z >= minZ; p = m_Nodes[p].m_PrevZ) {
+      if (p != prev && p != next && Blocks(a, b, c, m_Nodes[p])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+
+  // Unlink a clipped vertex from the ring and from the Z-order list.
+  void
+  Remove(
+    uint32_t p
+  ) {
+    NodeT& P = m_Nodes[p];
+    m_Nodes[P.m_Prev].m_Next = P.m_Next;
+    m_Nodes[P.m_Next].m_Prev = P.m_Prev;
+    if (m_Hashed) {
+      if (P.m_PrevZ != UINT32_MAX) {
+        m_Nodes[P.m_PrevZ].m_NextZ = P.m_NextZ;
+      }
+      if (P.m_NextZ != UINT32_MAX) {
+        m_Nodes[P.m_NextZ].m_PrevZ = P.m_PrevZ;
+      }
+    }
+  }
+
+
+  // Clip ears until one triangle is left.  When a full turn finds none, the
+  // next pass relaxes the test: first collinear vertices go (as zero area
+  // triangles, so the cap still shares every cut edge), then convex vertices
+  // regardless of what they overlap, then any vertex.
+  void
+  Clip(
+    uint32_t ear,
+    std::vector<uint32_t>& triangles
+  ) {
+    Index(ear);
+
+    uint32_t stop = ear;
+    int pass = 0;
+
+    while (m_Nodes[ear].m_Prev != m_Nodes[ear].m_Next) {
+      uint32_t prev = m_Nodes[ear].m_Prev, next = m_Nodes[ear].m_Next;
+      double area = Area(m_Nodes[prev], m_Nodes[ear], m_Nodes[next]);
+
+      bool clip = pass == 0 ? Ear(ear)
+                : pass == 1 ? area == 0
+                : pass == 2 ? area < 0
+                : true;
+
+      if (clip) {
+        triangles.push_back(m_Nodes[prev].m_Point);
+        triangles.push_back(m_Nodes[ear].m_Point);
+        triangles.push_back(m_Nodes[next].m_Point);
+
+        Remove(ear);
+        ear = stop = m_Nodes[next].m_Next;
+        pass = 0;
+        continue;
+      }
+
+      ear = next;
+      if (ear == stop) {
+        pass++;
+      }
+    }
+  }
+
+
+  const std::vector<std::array<double, 2>>& m_Plane;
+  std::vector<NodeT> m_Nodes;
+  bool m_Hashed = false;
+  double m_MinX = 0, m_MinY = 0, m_Scale = 0;
+};
+
+
+// Where the edge from lower vertex a to upper vertex b meets the plane.
+static inline Point
+Crossing(
+  const float* a,
+  double da,
+  const float* b,
+  double db
+) {
+  Point p;
+  if (db == 0) {
+    std::copy(b, b + 3, p.begin());
+    return p;
+  }
+  double t = da / (da - db);
+  for (int k = 0; k < 3; k++) {
+    p[k] = float(a[k] + (double(b[k]) - a[k]) * t);
+  }
+  return p;
+}
+
+
+static inline void
+Emit(
+  std::vector<STLFacetT>& out,
+  const STLFacetT& facet,
+  const float* a,
+  const float* b,
+  const float* c
+) {
+  if (std::equal(a, a + 3, b) || std::equal(b, b + 3, c) || std::equal(c, c + 3, a)) {
+    return;
+  }
+  STLFacetT f = facet;
+  std::copy(a, a + 3, f.m_Vertex1);
+  std::copy(b, b + 3, f.m_Vertex2);
+  std::copy(c, c + 3, f.m_Vertex3);
+  out.push_back(f);
+}
+
+
+// Split a facet into its parts on either side of the plane.  Vertices on
+// the plane belong to both sides, and a facet lying in the plane goes to the
+// side it bounds, the one its normal points away from.  Edges of upper parts
+// that lie in the plane are the upper half's open boundary, unless another
+// upper part shares them; they are kept, reversed, as cap segments.
+static void
+Clip(
+  const STLFacetT& facet,
+  const double (&n)[3],
+  double d,
+  std::vector<STLFacetT>& upper,
+  std::vector<STLFacetT>& lower,
+  std::vector<SegmentT>& segments
+) {
+  const float* v[3] = { facet.m_Vertex1, facet.m_Vertex2, facet.m_Vertex3 };
+  double dist[3];
+  int nUp = 0, nDown = 0;
+  for (int i = 0; i < 3; i++) {
+    dist[i] = n[0] * v[i][0] + n[1] * v[i][1] + n[2] * v[i][2] - d;
+    nUp += dist[i] > 0;
+    nDown += dist[i] < 0;
+  }
+
+  if (!nUp && !nDown) {
+    double e1[3], e2[3];
+    for (int k = 0; k < 3; k++) {
+      e1[k] = double(v[1][k]) - v[0][k];
+      e2[k] = double(v[2][k]) - v[0][k];
+    }
+    double facing = n[0] * (e1[1] * e2[2] - e1[2] * e2[1]) +
+                    n[1] * (e1[2] * e2[0] - e1[0] * e2[2]) +
+                    n[2] * (e1[0] * e2[1] - e1[1] * e2[0]);
+    if (facing > 0) {
+      lower.push_back(facet);
+      return;
+    }
+    if (facing == 0) {
+      return;
+    }
+  } else if (!nUp) {
+    lower.push_back(facet);
+    return;
+  }
+
+  // Upper and lower polygons, crossings computed from the lower to the upper
+  // end of an edge so both facets sharing it produce the same point.
+  Point above[4], below[4];
+  bool plane[4];
+  int nAbove = 0, nBelow = 0;
+  auto point = [](const float* p) { return Point{ p[0], p[1], p[2] }; };
+  for (int i = 0; i < 3; i++) {
+    int j = (i + 1) % 3;
+    if (dist[i] >= 0) {
+      plane[nAbove] = dist[i] == 0;
+      above[nAbove++] = point(v[i]);
+    }
+    if (dist[i] <= 0) {
+      below[nBelow++] = point(v[i]);
+    }
+    if ((dist[i] < 0 && dist[j] > 0) || (dist[i] > 0 && dist[j] < 0)) {
+      Point p = dist[i] < 0 ? Crossing(v[i], dist[i], v[j], dist[j])
+                            : Crossing(v[j], dist[j], v[i], dist[i]);
+      plane[nAbove] = true;
+      above[nAbove++] = p;
+      below[nBelow++] = p;
+    }
+  }
+
+  if (!nDown) {
+    upper.push_back(facet);
+  } else {
+    for (int k = 1; k + 1 < nAbove; k++) {
+      Emit(upper, facet, above[0].data(), above[k].data(), above[k + 1].data());
+    }
+    for (int k = 1; k + 1 < nBelow; k++) {
+      Emit(lower, facet, below[0].data(), below[k].data(), below[k + 1].data());
+    }
+  }
+
+  for (int i = 0; i < nAbove; i++) {
+    int j = (i + 1) % nAbove;
+    if (plane[i] && plane[j] && above[i] != above[j]) {
+      segments.push_back(SegmentT{ above[j], above[i] });
+    }
+  }
+}
+
+
+// Chain cut edges into closed loops of point indices.  Opposite edges cancel,
+// as where two upper facets in the plane meet.  Chains that do not close
+// (open input) are dropped.
+static void
+Loops(
+  const std::vector<SegmentT>& segments,
+  std::vector<Point>& points,
+  std::vector<std::vector<uint32_t>>& loops
+) {
+  std::unordered_map<Point, uint32_t, PointHash> ids;
+  std::vector<std::array<uint32_t, 2>> edges;
+  edges.reserve(segments.size());
+  auto id = [&](const Point& p) {
+    auto [it, inserted] = ids.try_emplace(p, points.size());
+    if (inserted) {
+      points.push_back(p);
+    }
+    return it->second;
+  };
+  std::unordered_map<uint64_t, long> net;
+  std::vector<uint64_t> order;
+  for (auto& s : segments) {
+    uint32_t from = id(s.m_From), to = id(s.m_To);
+    uint64_t key = uint64_t(std::min(from, to)) << 32 | std::max(from, to);
+    auto [it, inserted] = net.try_emplace(key, 0);
+    if (inserted) {
+      order.push_back(key);
+    }
+    it->second += from < to ? 1 : -1;
+  }
+  for (auto key : order) {
+    uint32_t a = key >> 32, b = uint32_t(key);
+    for (long k = net[key]; k != 0; k -= k > 0 ? 1 : -1) {
+      edges.push_back(k > 0 ? std::array<uint32_t, 2>{ a, b } : std::array<uint32_t, 2>{ b, a });
+    }
+  }
+
+  // Outgoing edges of each point, in input order.
+  std::vector<uint32_t> first(points.size() + 1, 0), out(edges.size());
+  for (auto& e : edges) {
+    first[e[0] + 1]++;
+  }
+  for (size_t i = 1; i < first.size(); i++) {
+    first[i] += first[i - 1];
+  }
+  std::vector<uint32_t> cursor(first.begin(), first.end() - 1);
+  for (uint32_t e = 0; e < edges.size(); e++) {
+    out[cursor[edges[e][0]]++] = e;
+  }
+
+  std::vector<char> used(edges.size(), 0);
+  std::vector<uint32_t> next(points.size());
+  std::copy(first.begin(), first.end() - 1, next.begin());
+
+  for (uint32_t e = 0; e < edges.size(); e++) {
+    if (used[e]) {
+      continue;
+    }
+
+    std::vector<uint32_t> loop;
+    uint32_t start = edges[e][0], at = e;
+    bool closed = false;
+    while (true) {
+      used[at] = 1;
+      loop.push_back(edges[at][0]);
+      uint32_t to = edges[at][1];
+      if (to == start) {
+        closed = true;
+        break;
+      }
+      while (next[to] < first[to + 1] && used[out[next[to]]]) {
+        next[to]++;
+      }
+      if (next[to] == first[to + 1]) {
+        break;
+      }
+      at = out[next[to]];
+    }
+
+    if (closed && loop.size() >= 3) {
+      loops.push_back(std::move(loop));
+    }
+  }
+}
+
+
+static double
+LoopArea(
+  const std::vector<std::array<double, 2>>& plane,
+  const std::vector<uint32_t>& loop
+) {
+  double area = 0;
+  for (size_t i = 0, j = loop.size() - 1; i < loop.size(); j = i++) {
+    area += plane[loop[j]][0] * plane[loop[i]][1] - plane[loop[i]][0] * plane[loop[j]][1];
+  }
+  return area / 2;
+}
+
+
+static bool
+Contains(
+  const std::vector<std::array<double, 2>>& plane,
+  const std::vector<uint32_t>& loop,
+  const std::array<double, 2>& p
+) {
+  bool inside = false;
+  for (size_t i = 0, j = loop.size() - 1; i < loop.size(); j = i++) {
+    auto& a = plane[loop[i]];
+    auto& b = plane[loop[j]];
+    if ((a[1] > p[1]) != (b[1] > p[1]) &&
+        p[0] < (b[0] - a[0]) * (p[1] - a[1]) / (b[1] - a[1]) + a[0]) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+
+static STLFacetT
+Facet(
+  const Point& a,
+  const Point& b,
+  const Point& c,
+  const float (&normal)[3]
+) {
+  STLFacetT f;
+  std::copy(normal, normal + 3, f.m_Normal);
+  std::copy(a.begin(), a.end(), f.m_Vertex1);
+  std::copy(b.begin(), b.end(), f.m_Vertex2);
+  std::copy(c.begin(), c.end(), f.m_Vertex3);
+  f.m_Attr = 0;
+  return f;
+}
+
+
+long
+Cut(
+  const STLFacet* facets,
+  size_t count,
+  const float (&plane)[4],
+  int threads,
+  std::vector<STLFacet>& upper,
+  std::vector<STLFacet>& lower
+) {
+  double length = std::sqrt(double(plane[0]) * plane[0] + double(plane[1]) * plane[1] +
+                            double(plane[2]) * plane[2]);
+  if (!(length > 0)) {
+    return -1;
+  }
+  const double n[3] = { plane[0] / length, plane[1] / length, plane[2] / length };
+  const double d = plane[3] / length;
+
+  int nWorkers = ParallelSTL::Workers(threads, count);
+  std::vector<std::vector<STLFacetT>> uppers(nWorkers), lowers(nWorkers);
+  std::vector<std::vector<SegmentT>> cuts(nWorkers);
+
+  ParallelSTL::For(threads, count, [&](size_t begin, size_t end, int thread) {
+    for (size_t i = begin; i < end; i++) {
+      Clip(facets[i], n, d, uppers[thread], lowers[thread], cuts[thread]);
+    }
+  });
+
+  auto gather = [](auto& parts, auto& all) {
+    size_t total = 0;
+    for (auto& part : parts) {
+      total += part.size();
+    }
+    all.clear();
+    all.reserve(total);
+    for (auto& part : parts) {
+      all.insert(all.end(), part.begin(), part.end());
+      std::vector<typename std::decay_t<decltype(part)>::value_type>().swap(part);
+    }
+  };
+  std::vector<SegmentT> segments;
+  gather(uppers, upper);
+  gather(lowers, lower);
+  gather(cuts, segments);
+
+  if (upper.empty() || lower.empty()) {
+    upper.clear();
+    lower.clear();
+    return -2;
+  }
+
+  std::vector<Point> points;
+  std::vector<std::vector<uint32_t>> loops;
+  Loops(segments, points, loops);
+
+  // Plane coordinates with u x v = n.  The upper cap faces -n, so seen along
+  // n its outer loops run clockwise and its holes counter-clockwise.
+  int axis = 0;
+  for (int k = 1; k < 3; k++) {
+    axis = std::fabs(n[k]) < std::fabs(n[axis]) ? k : axis;
+  }
+  double e[3] = { 0, 0, 0 };
+  e[axis] = 1;
+  double u[3] = { n[1] * e[2] - n[2] * e[1], n[2] * e[0] - n[0] * e[2], n[0] * e[1] - n[1] * e[0] };
+  double ul = std::sqrt(u[0] * u[0] + u[1] * u[1] + u[2] * u[2]);
+  for (auto& c : u) {
+    c /= ul;
+  }
+  double v[3] = { n[1] * u[2] - n[2] * u[1], n[2] * u[0] - n[0] * u[2], n[0] * u[1] - n[1] * u[0] };
+
+  std::vector<std::array<double, 2>> flat(points.size());
+  for (size_t i = 0; i < points.size(); i++) {
+    auto& p = points[i];
+    flat[i] = { u[0] * p[0] + u[1] * p[1] + u[2] * p[2], v[0] * p[0] + v[1] * p[1] + v[2] * p[2] };
+  }
+
+  // Reverse every loop, making outer loops counter-clockwise and holes
+  // clockwise, and give each hole to the smallest outer loop around it.
+  std::vector<uint32_t> outers, holes;
+  std::vector<double> areas(loops.size());
+  for (uint32_t i = 0; i < loops.size(); i++) {
+    std::reverse(loops[i].begin(), loops[i].end());
+    areas[i] = LoopArea(flat, loops[i]);
+    if (areas[i] > 0) {
+      outers.push_back(i);
+    } else if (areas[i] < 0) {
+      holes.push_back(i);
+    }
+  }
+
+  std::vector<std::vector<const std::vector<uint32_t>*>> inner(outers.size());
+  for (auto h : holes) {
+    auto& p = flat[loops[h][0]];
+    size_t best = outers.size();
+    for (size_t o = 0; o < outers.size(); o++) {
+      if ((best == outers.size() || areas[outers[o]] < areas[outers[best]]) &&
+          Contains(flat, loops[outers[o]], p)) {
+        best = o;
+      }
+    }
+    if (best < outers.size()) {
+      inner[best].push_back(&loops[h]);
+    }
+  }
+
+  std::vector<std::vector<uint32_t>> triangles(outers.size());
+  ParallelSTL::For(threads, outers.size(), [&](size_t begin, size_t end, int) {
+    Triangulator triangulator(flat);
+    for (size_t o = begin; o < end; o++) {
+      triangulator.Run(loops[outers[o]], inner[o], triangles[o]);
+    }
+  }, 1);
+
+  const float up[3] = { float(-n[0]), float(-n[1]), float(-n[2]) };
+  const float down[3] = { float(n[0]), float(n[1]), float(n[2]) };
+  for (auto& cap : triangles) {
+    for (size_t t = 0; t < cap.size(); t += 3) {
+      auto& a = points[cap[t]];
+      auto& b = points[cap[t + 1]];
+      auto& c = points[cap[t + 2]];
+      upper.push_back(Facet(a, c, b, up));
+      lower.push_back(Facet(a, b, c, down));
+    }
+  }
+
+  return long(outers.size());
+}
+
+
+} /* namespace CutSTL */
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+struct STLFacet;
+
+namespace CutSTL {
+
+
+// Split a closed mesh by the plane n . p = d, given as { nx, ny, nz, d }.
+// Facets are clipped in one parallel pass; a facet lying in the plane goes to
+// the half it bounds, the side its normal points away from.  Crossings are
+// computed from the lower to the upper end of an edge, so both facets sharing
+// the edge produce the same point.  The upper half's open edges in the plane
+// are then chained into loops, nested loops become holes, and each outer loop
+// is ear clipped into a cap that closes both halves.  Returns the number of
+// cap loops, -1 for a zero normal, or -2 (and no halves) when the plane does
+// not cross the mesh.
+long
+Cut(
+  const STLFacet* facets,
+  size_t count,
+  const float (&plane)[4],
+  int threads,
+  std::vector<STLFacet>& upper,
+  std::vector<STLFacet>& lower
+);
+
+
+} /* namespace CutSTL */
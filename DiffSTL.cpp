@@ -0,0 +1,145 @@
+#include "DiffSTL.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#include "STLBIfc.hpp"
+#include "CurveSTL.hpp"
+#include "ParallelSTL.hpp"
+
+
+namespace DiffSTL {
+
+
+static inline uint64_t
+Mix(
+  uint64_t h
+) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+
+uint64_t
+Key(
+  const STLFacet& facet,
+  float quantum
+) {
+  const float* v[3] = { facet.m_Vertex1, facet.m_Vertex2, facet.m_Vertex3 };
+  int64_t grid[3][3];
+  for (int i = 0; i < 3; i++) {
+    for (int k = 0; k < 3; k++) {
+      grid[i][k] = std::llround(double(v[i][k]) / quantum);
+    }
+  }
+
+  // The least of the three rotations, so any starting vertex gives one key.
+  auto less = [&](int r, int s) {
+    for (int i = 0; i < 3; i++) {
+      for (int k = 0; k < 3; k++) {
+        int64_t a = grid[(r + i) % 3][k], b = grid[(s + i) % 3][k];
+        if (a != b) {
+          return a < b;
+        }
+      }
+    }
+    return false;
+  };
+  int start = less(1, 0) ? 1 : 0;
+  start = less(2, start) ? 2 : start;
+
+  uint64_t h = 0x9e3779b97f4a7c15ULL;
+  for (int i = 0; i < 3; i++) {
+    for (int k = 0; k < 3; k++) {
+      h = Mix(h ^ uint64_t(grid[(start + i) % 3][k])) + 0x9e3779b97f4a7c15ULL;
+    }
+  }
+  return Mix(h);
+}
+
+
+uint64_t
+Hash(
+  const STLFacet* facets,
+  size_t count,
+  float quantum,
+  int threads
+) {
+  std::vector<uint64_t> sums(ParallelSTL::Workers(threads, count), 0);
+  ParallelSTL::For(threads, count, [&](size_t begin, size_t end, int thread) {
+    uint64_t sum = 0;
+    for (size_t i = begin; i < end; i++) {
+      sum += Key(facets[i], quantum);
+    }
+    sums[thread] = sum;
+  });
+
+  uint64_t sum = 0;
+  for (auto s : sums) {
+    sum += s;
+  }
+  return Mix(sum ^ count);
+}
+
+
+// Keys of facets sorted, with the facet index of each.  CurveSTL::Sort orders
+// 63 bits, so the lowest key bit is dropped.
+static void
+Sorted(
+  const STLFacet* facets,
+  size_t count,
+  float quantum,
+  int threads,
+  std::vector<uint64_t>& keys,
+  std::vector<uint32_t>& order
+) {
+  keys.resize(count);
+  ParallelSTL::For(threads, count, [&](size_t begin, size_t end, int) {
+    for (size_t i = begin; i < end; i++) {
+      keys[i] = Key(facets[i], quantum) >> 1;
+    }
+  });
+  CurveSTL::Sort(keys, threads, order);
+}
+
+
+void
+Diff(
+  const STLFacet* a,
+  size_t na,
+  const STLFacet* b,
+  size_t nb,
+  float quantum,
+  int threads,
+  std::vector<uint32_t>& removed,
+  std::vector<uint32_t>& added
+) {
+  std::vector<uint64_t> keysA, keysB;
+  std::vector<uint32_t> orderA, orderB;
+  Sorted(a, na, quantum, threads, keysA, orderA);
+  Sorted(b, nb, quantum, threads, keysB, orderB);
+
+  removed.clear();
+  added.clear();
+  size_t i = 0, j = 0;
+  while (i < na || j < nb) {
+    if (j == nb || (i < na && keysA[i] < keysB[j])) {
+      removed.push_back(orderA[i++]);
+    } else if (i == na || keysB[j] < keysA[i]) {
+      added.push_back(orderB[j++]);
+    } else {
+      i++;
+      j++;
+    }
+  }
+
+  std::sort(removed.begin(), removed.end());
+  std::sort(added.begin(), added.end());
+}
+
+
+} /* namespace DiffSTL */
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct STLFacet;
+
+namespace DiffSTL {
+
+
+// Key of a facet's geometry: vertices snapped to a grid of quantum, rotated
+// to start at the smallest (keeping the winding), and hashed.  Normals and
+// attributes are ignored.
+uint64_t
+Key(
+  const STLFacet& facet,
+  float quantum
+);
+
+
+// Order independent hash of the facets as a multiset: the sum of their keys,
+// accumulated per worker, mixed with the count.  Independent of facet order,
+// header and threads.
+uint64_t
+Hash(
+  const STLFacet* facets,
+  size_t count,
+  float quantum,
+  int threads
+);
+
+
+// Multiset difference of a and b by key.  Keys of both are radix sorted and
+// merged; removed lists the facets of a left unmatched in b and added those
+// of b left unmatched in a, both in ascending facet order.
+void
+Diff(
+  const STLFacet* a,
+  size_t na,
+  const STLFacet* b,
+  size_t nb,
+  float quantum,
+  int threads,
+  std::vector<uint32_t>& removed,
+  std::vector<uint32_t>& added
+);
+
+
+} /* namespace DiffSTL */
@@ -0,0 +1,185 @@
+#include "FormatSTL.hpp"
+
+#include <vector>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+
+#include "STLBIfc.hpp"
+#include "ParallelSTL.hpp"
+
+#define FORMAT_CHUNK_FACETS 16384
+#define FORMAT_FACET_BYTES  512       // Bound on the text of one facet.
+
+
+namespace FormatSTL {
+
+
+static inline char*
+Text(
+  char* out,
+  const char* text
+) {
+  size_t length = std::strlen(text);
+  std::memcpy(out, text, length);
+  return out + length;
+}
+
+
+// As std::ostream prints a float by default: %g, precision 6.
+static inline char*
+General(
+  char* out,
+  float value
+) {
+  return std::to_chars(out, out + 32, value, std::chars_format::general, 6).ptr;
+}
+
+
+// Shortest text that reads back as the same float.
+static inline char*
+Shortest(
+  char* out,
+  float value
+) {
+  return std::to_chars(out, out + 32, value).ptr;
+}
+
+
+static char*
+DumpVector(
+  char* out,
+  const char* label,
+  const float (&xyz)[3]
+) {
+  out = Text(out, label);
+  out = General(out, xyz[0]);
+  out = Text(out, ", ");
+  out = General(out, xyz[1]);
+  out = Text(out, ", ");
+  out = General(out, xyz[2]);
+  *out++ = '\n';
+  return out;
+}
+
+
+static char*
+AsciiVector(
+  char* out,
+  const char* label,
+  const float (&xyz)[3]
+) {
+  out = Text(out, label);
+  for (int k = 0; k < 3; k++) {
+    *out++ = ' ';
+    out = Shortest(out, xyz[k]);
+  }
+  *out++ = '\n';
+  return out;
+}
+
+
+// Format facets [0, count) chunk by chunk: each round, every worker fills
+// its own buffer with one chunk, then the buffers are written in chunk order.
+template<typename Format>
+static void
+Write(
+  std::ostream& out,
+  size_t count,
+  int threads,
+  Format&& format
+) {
+  size_t chunks = (count + FORMAT_CHUNK_FACETS - 1) / FORMAT_CHUNK_FACETS;
+  int nWorkers = ParallelSTL::Workers(threads, chunks, 1);
+  std::vector<std::vector<char>> buffers(nWorkers);
+  std::vector<size_t> lengths(nWorkers);
+
+  for (size_t round = 0; round < chunks; round += nWorkers) {
+    size_t batch = std::min<size_t>(nWorkers, chunks - round);
+
+    ParallelSTL::For(threads, batch, [&](size_t begin, size_t end, int) {
+      for (size_t b = begin; b < end; b++) {
+        size_t first = (round + b) * FORMAT_CHUNK_FACETS;
+        size_t last = std::min(count, first + FORMAT_CHUNK_FACETS);
+
+        auto& buffer = buffers[b];
+        buffer.resize((last - first) * FORMAT_FACET_BYTES);
+        char* end = buffer.data();
+        for (size_t i = first; i < last; i++) {
+          end = format(end, i);
+        }
+        lengths[b] = end - buffer.data();
+      }
+    }, 1);
+
+    for (size_t b = 0; b < batch; b++) {
+      out.write(buffers[b].data(), lengths[b]);
+    }
+  }
+}
+
+
+bool
+Dump(
+  std::ostream& out,
+  const STLFacet* facets,
+  size_t count,
+  int threads
+) {
+  // Everything up to the first invalid facet is printed.
+  size_t valid = count;
+  for (size_t i = 0; i < count; i++) {
+    if (facets[i].m_Attr != 0) {
+      valid = i;
+      break;
+    }
+  }
+
+  Write(out, valid, threads, [&](char* end, size_t i) {
+    end = Text(end, "Facet: ");
+    end = std::to_chars(end, end + 24, i).ptr;
+    *end++ = '\n';
+    end = DumpVector(end, "\tNormal: ", facets[i].m_Normal);
+    end = DumpVector(end, "\tVertex1: ", facets[i].m_Vertex1);
+    end = DumpVector(end, "\tVertex2: ", facets[i].m_Vertex2);
+    end = DumpVector(end, "\tVertex3: ", facets[i].m_Vertex3);
+    return end;
+  });
+
+  if (valid < count) {
+    out << "Facet: " << valid << "\n" << "Invalid or Corrupt STLB.\n";
+  }
+  out.flush();
+
+  return valid == count;
+}
+
+
+bool
+Ascii(
+  std::ostream& out,
+  const std::string& name,
+  const STLFacet* facets,
+  size_t count,
+  int threads
+) {
+  out << "solid " << name << "\n";
+
+  Write(out, count, threads, [&](char* end, size_t i) {
+    end = AsciiVector(end, "  facet normal", facets[i].m_Normal);
+    end = Text(end, "    outer loop\n");
+    end = AsciiVector(end, "      vertex", facets[i].m_Vertex1);
+    end = AsciiVector(end, "      vertex", facets[i].m_Vertex2);
+    end = AsciiVector(end, "      vertex", facets[i].m_Vertex3);
+    end = Text(end, "    endloop\n  endfacet\n");
+    return end;
+  });
+
+  out << "endsolid " << name << "\n";
+  out.flush();
+
+  return bool(out);
+}
+
+
+} /* namespace FormatSTL */
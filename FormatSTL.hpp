@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <ostream>
+
+struct STLFacet;
+
+namespace FormatSTL {
+
+
+// Text for facets [0, count): the lines Dump prints, or an ASCII STL
+// solid.  Chunks of facets are formatted with std::to_chars into one buffer
+// per thread and written to out in order with one write per chunk, so the
+// bytes do not depend on the number of threads.
+//
+// Dump stops after the "Facet: i" line of the first facet with a non-zero
+// attribute, as STLBObj::Dump always has, and returns false there.
+bool
+Dump(
+  std::ostream& out,
+  const STLFacet* facets,
+  size_t count,
+  int threads
+);
+
+
+// Coordinates are written in the shortest form that reads back to the
+// same float.
+bool
+Ascii(
+  std::ostream& out,
+  const std::string& name,
+  const STLFacet* facets,
+  size_t count,
+  int threads
+);
+
+
+} /* namespace FormatSTL */
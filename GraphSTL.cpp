@@ -1,9 +1,11 @@
 #include "GraphSTL.hpp"
 
 #include <map>
+#include <algorithm>
 #include <list>
 #include <tuple>
 #include <vector>
+#include <numeric>
 
 
 namespace GraphSTL {
@@ -50,6 +52,7 @@ public:
   VertexID m_Vertex3;
   TriangleID m_ID;
   uint16_t m_Attributes;
+  uint32_t m_Index = 0;
 };
 
 
@@ -75,6 +78,7 @@ public:
     uint16_t attributes
   ) {
     auto triangle = Triangle::Create(normal, vertex1, vertex2, vertex3, attributes);
+    triangle->m_Index = m_Count++;
     m_VertexTriangles[triangle->m_Vertex1].push_back(triangle);
     m_VertexTriangles[triangle->m_Vertex2].push_back(triangle);
     m_VertexTriangles[triangle->m_Vertex3].push_back(triangle);
@@ -155,6 +159,58 @@ public:
     }
   }
 
+  size_t
+  ManifoldLabels(
+    std::vector<uint32_t>& labels,
+    std::vector<uint32_t>& weld
+  ) {
+    // Union triangles sharing a vertex, then number the roots.
+    std::vector<uint32_t> parent(m_Count);
+    std::iota(parent.begin(), parent.end(), 0);
+
+    auto find = [&](uint32_t i) {
+      while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+      }
+      return i;
+    };
+
+    weld.resize(3 * size_t(m_Count));
+    uint32_t id = 0;
+
+    for (const auto& [vertex, triangles] : m_VertexTriangles) {
+      auto root = find(triangles.front()->m_Index);
+      for (const auto& triangle : triangles) {
+        auto corner = 3 * size_t(triangle->m_Index);
+        if (triangle->m_Vertex1 == vertex) weld[corner + 0] = id;
+        if (triangle->m_Vertex2 == vertex) weld[corner + 1] = id;
+        if (triangle->m_Vertex3 == vertex) weld[corner + 2] = id;
+
+        auto other = find(triangle->m_Index);
+        if (other != root) {
+          parent[std::max(root, other)] = std::min(root, other);
+          root = std::min(root, other);
+        }
+      }
+      id++;
+    }
+
+    std::vector<uint32_t> object(m_Count, UINT32_MAX);
+    labels.resize(m_Count);
+    size_t objects = 0;
+    for (uint32_t i = 0; i < m_Count; i++) {
+      auto root = find(i);
+      if (object[root] == UINT32_MAX) {
+        object[root] = objects++;
+      }
+      labels[i] = object[root];
+    }
+
+    return objects;
+  }
+
+  uint32_t m_Count = 0;
   std::map<Triangle::VertexID, Triangle::TrianglePtrList> m_VertexTriangles;
   std::map<Triangle::TriangleID, Triangle::VertexList>    m_TriangleVertices;
   std::map<Triangle::TriangleID, Triangle::TrianglePtr>   m_Triangles;
@@ -217,4 +273,14 @@ ManifoldObjects(
   ctx->ManifoldObjects(objects);
 }
 
+
+size_t
+ManifoldLabels(
+  ContextPtr ctx,
+  std::vector<uint32_t>& labels,
+  std::vector<uint32_t>& weld
+) {
+  return ctx->ManifoldLabels(labels, weld);
+}
+
 } /* namespace GraphSTL */
@@ -2,6 +2,8 @@
 
 #include <memory>
 #include <list>
+#include <vector>
+#include <cstdint>
 
 namespace GraphSTL {
 
@@ -45,5 +47,15 @@ ManifoldObjects(
   std::list<TrianglePtrList>& objects
 );
 
+// Label every triangle, in the order added, with the index of the manifold
+// object it belongs to.  Objects are numbered by first appearance.  weld
+// receives a unique id per distinct vertex, three entries per triangle.
+size_t
+ManifoldLabels(
+  ContextPtr ctx,
+  std::vector<uint32_t>& labels,
+  std::vector<uint32_t>& weld
+);
+
 
 } /* namespace GraphSTL */
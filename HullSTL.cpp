@@ -0,0 +1,523 @@
+#include "HullSTL.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+
+#include "ParallelSTL.hpp"
+
+#define HULL_PARALLEL_POINTS (1 << 16)
+#define HULL_GRID_BITS       24
+
+
+namespace HullSTL {
+
+
+// Quickhull with exact orientation tests.  Points are snapped to a 2^24 grid
+// over their bounding box (float precision at the extremes), which merges
+// near-duplicate vertices and lets every predicate be evaluated exactly in
+// integer arithmetic, so the hull stays convex on degenerate input.
+class Builder {
+public:
+  using GridPoint = std::array<int32_t, 3>;
+
+  Builder(
+    const std::vector<Point>& points,
+    int threads
+  ) : m_Points(points), m_Threads(threads) {}
+
+
+  bool
+  Build(
+    std::vector<Face>& faces
+  ) {
+    faces.clear();
+
+    if (m_Points.size() < 4 || !Snap()) {
+      return false;
+    }
+
+    uint32_t simplex[4];
+    if (!Simplex(simplex)) {
+      return false;
+    }
+
+    for (int i = 0; i < 4; i++) {
+      uint32_t a = simplex[i], b = simplex[(i + 1) % 4], c = simplex[(i + 2) % 4];
+      uint32_t f = NewFace(a, b, c);
+      if (Side(m_Faces[f], simplex[(i + 3) % 4]) > 0) {
+        std::swap(m_Faces[f].m_V[1], m_Faces[f].m_V[2]);
+        SetPlane(m_Faces[f]);
+      }
+    }
+    LinkSimplex();
+
+    // Assign every point to the first face it lies outside of; points inside
+    // the simplex are dropped here, which is the bulk of any large input.
+    std::vector<uint32_t> initial(m_Points.size());
+    for (uint32_t i = 0; i < initial.size(); i++) {
+      initial[i] = i;
+    }
+    std::vector<uint32_t> created {0, 1, 2, 3};
+    Assign(initial, created);
+
+    for (auto f : created) {
+      Unique(m_Faces[f].m_Outside);
+      Furthest(m_Faces[f]);
+    }
+
+    std::vector<uint32_t> pending(created);
+    uint32_t stamp = 0;
+
+    while (!pending.empty()) {
+      uint32_t f = pending.back();
+      pending.pop_back();
+
+      if (!m_Faces[f].m_Alive || m_Faces[f].m_Outside.empty()) {
+        continue;
+      }
+
+      uint32_t eye = m_Faces[f].m_Furthest;
+
+      // Flood the faces visible from the eye point.
+      stamp++;
+      std::vector<uint32_t> visible {f};
+      m_Faces[f].m_Visible = stamp;
+      for (size_t i = 0; i < visible.size(); i++) {
+        for (auto n : m_Faces[visible[i]].m_Neighbor) {
+          if (m_Faces[n].m_Visible != stamp && Side(m_Faces[n], eye) > 0) {
+            m_Faces[n].m_Visible = stamp;
+            visible.push_back(n);
+          }
+        }
+      }
+
+      // Cone the horizon to the eye point.
+      created.clear();
+      std::unordered_map<uint32_t, uint32_t> starts, ends;
+      for (auto v : visible) {
+        for (int k = 0; k < 3; k++) {
+          uint32_t n = m_Faces[v].m_Neighbor[k];
+          if (m_Faces[n].m_Visible == stamp) {
+            continue;
+          }
+
+          uint32_t a = m_Faces[v].m_V[k];
+          uint32_t b = m_Faces[v].m_V[(k + 1) % 3];
+          uint32_t g = NewFace(a, b, eye);
+          m_Faces[g].m_Neighbor[0] = n;
+          for (int j = 0; j < 3; j++) {
+            if (m_Faces[n].m_V[j] == b && m_Faces[n].m_V[(j + 1) % 3] == a) {
+              m_Faces[n].m_Neighbor[j] = g;
+            }
+          }
+          starts[a] = g;
+          ends[b] = g;
+          created.push_back(g);
+        }
+      }
+
+      for (auto g : created) {
+        m_Faces[g].m_Neighbor[1] = starts[m_Faces[g].m_V[1]];
+        m_Faces[g].m_Neighbor[2] = ends[m_Faces[g].m_V[0]];
+      }
+
+      std::vector<uint32_t> orphans;
+      for (auto v : visible) {
+        auto& face = m_Faces[v];
+        face.m_Alive = false;
+        for (auto i : face.m_Outside) {
+          if (i != eye) {
+            orphans.push_back(i);
+          }
+        }
+        std::vector<uint32_t>().swap(face.m_Outside);
+      }
+
+      Assign(orphans, created);
+
+      for (auto g : created) {
+        if (!m_Faces[g].m_Outside.empty()) {
+          Furthest(m_Faces[g]);
+          pending.push_back(g);
+        }
+      }
+    }
+
+    for (const auto& face : m_Faces) {
+      if (face.m_Alive) {
+        faces.push_back({face.m_V[0], face.m_V[1], face.m_V[2]});
+      }
+    }
+
+    return true;
+  }
+
+
+private:
+  struct HullFace {
+    uint32_t m_V[3];
+    uint32_t m_Neighbor[3];   // across edge m_V[k] -> m_V[k + 1]
+    double   m_Normal[3];
+    double   m_Offset;
+    std::vector<uint32_t> m_Outside;
+    uint32_t m_Furthest = 0;
+    uint32_t m_Visible = 0;
+    bool     m_Alive = true;
+  };
+
+
+  bool
+  Snap() {
+    size_t n = m_Points.size();
+    int workers = ParallelSTL::Workers(m_Threads, n);
+    std::vector<std::array<float, 6>> bounds(workers);
+
+    ParallelSTL::For(m_Threads, n, [&](size_t begin, size_t end, int t) {
+      auto& b = bounds[t];
+      for (int k = 0; k < 3; k++) {
+        b[2 * k] = b[2 * k + 1] = m_Points[begin][k];
+      }
+      for (size_t i = begin; i < end; i++) {
+        for (int k = 0; k < 3; k++) {
+          b[2 * k] = std::min(b[2 * k], m_Points[i][k]);
+          b[2 * k + 1] = std::max(b[2 * k + 1], m_Points[i][k]);
+        }
+      }
+    });
+
+    double center[3];
+    double extent = 0;
+    for (int k = 0; k < 3; k++) {
+      double low = bounds[0][2 * k], high = bounds[0][2 * k + 1];
+      for (const auto& b : bounds) {
+        low = std::min<double>(low, b[2 * k]);
+        high = std::max<double>(high, b[2 * k + 1]);
+      }
+      center[k] = (low + high) / 2;
+      extent = std::max(extent, high - low);
+    }
+
+    if (!(extent > 0) || !std::isfinite(extent)) {
+      return false;
+    }
+
+    double scale = double(1 << HULL_GRID_BITS) / extent;
+    m_Grid.resize(n);
+    ParallelSTL::For(m_Threads, n, [&](size_t begin, size_t end, int) {
+      for (size_t i = begin; i < end; i++) {
+        for (int k = 0; k < 3; k++) {
+          m_Grid[i][k] = int32_t(std::llround((m_Points[i][k] - center[k]) * scale));
+        }
+      }
+    });
+
+    return true;
+  }
+
+
+  // Exact orientation of point i against the face: positive outside,
+  // negative inside, zero when coplanar.  Grid coordinates differ by at most
+  // 2^25, so the 2x2 minors fit in 64 bits and the determinant in 128.
+  int
+  Side(
+    const HullFace& face,
+    uint32_t i
+  ) const {
+    const GridPoint& a = m_Grid[face.m_V[0]];
+    const GridPoint& b = m_Grid[face.m_V[1]];
+    const GridPoint& c = m_Grid[face.m_V[2]];
+    const GridPoint& p = m_Grid[i];
+
+    int64_t ux = int64_t(b[0]) - a[0], uy = int64_t(b[1]) - a[1], uz = int64_t(b[2]) - a[2];
+    int64_t vx = int64_t(c[0]) - a[0], vy = int64_t(c[1]) - a[1], vz = int64_t(c[2]) - a[2];
+    int64_t wx = int64_t(p[0]) - a[0], wy = int64_t(p[1]) - a[1], wz = int64_t(p[2]) - a[2];
+
+    __int128 det = __int128(wx) * (uy * vz - uz * vy) +
+                   __int128(wy) * (uz * vx - ux * vz) +
+                   __int128(wz) * (ux * vy - uy * vx);
+
+    return (det > 0) - (det < 0);
+  }
+
+
+  // Approximate distance, used only to pick the furthest outside point.
+  double
+  Distance(
+    const HullFace& face,
+    uint32_t i
+  ) const {
+    const GridPoint& p = m_Grid[i];
+    return face.m_Normal[0] * p[0] + face.m_Normal[1] * p[1] +
+           face.m_Normal[2] * p[2] - face.m_Offset;
+  }
+
+
+  void
+  SetPlane(
+    HullFace& face
+  ) {
+    const GridPoint& a = m_Grid[face.m_V[0]];
+    const GridPoint& b = m_Grid[face.m_V[1]];
+    const GridPoint& c = m_Grid[face.m_V[2]];
+
+    double u[3] = {double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2]};
+    double v[3] = {double(c[0]) - a[0], double(c[1]) - a[1], double(c[2]) - a[2]};
+    double n[3] = {
+      u[1] * v[2] - u[2] * v[1],
+      u[2] * v[0] - u[0] * v[2],
+      u[0] * v[1] - u[1] * v[0]
+    };
+
+    double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (length > 0) {
+      n[0] /= length; n[1] /= length; n[2] /= length;
+    }
+
+    face.m_Normal[0] = n[0];
+    face.m_Normal[1] = n[1];
+    face.m_Normal[2] = n[2];
+    face.m_Offset = n[0] * a[0] + n[1] * a[1] + n[2] * a[2];
+  }
+
+
+  uint32_t
+  NewFace(
+    uint32_t a,
+    uint32_t b,
+    uint32_t c
+  ) {
+    m_Faces.emplace_back();
+    auto& face = m_Faces.back();
+    face.m_V[0] = a;
+    face.m_V[1] = b;
+    face.m_V[2] = c;
+    SetPlane(face);
+    return m_Faces.size() - 1;
+  }
+
+
+  void
+  LinkSimplex() {
+    for (uint32_t f = 0; f < 4; f++) {
+      for (int k = 0; k < 3; k++) {
+        uint32_t a = m_Faces[f].m_V[k];
+        uint32_t b = m_Faces[f].m_V[(k + 1) % 3];
+        for (uint32_t g = 0; g < 4; g++) {
+          for (int j = 0; j < 3; j++) {
+            if (m_Faces[g].m_V[j] == b && m_Faces[g].m_V[(j + 1) % 3] == a) {
+              m_Faces[f].m_Neighbor[k] = g;
+            }
+          }
+        }
+      }
+    }
+  }
+
+
+  // Largest spread pair of axis extremes, then the furthest points from
+  // their line and from the resulting plane.
+  bool
+  Simplex(
+    uint32_t (&simplex)[4]
+  ) {
+    size_t n = m_Grid.size();
+    int workers = ParallelSTL::Workers(m_Threads, n);
+    std::vector<std::array<uint32_t, 6>> extremes(workers);
+
+    ParallelSTL::For(m_Threads, n, [&](size_t begin, size_t end, int t) {
+      auto& e = extremes[t];
+      e.fill(begin);
+      for (size_t i = begin; i < end; i++) {
+        for (int k = 0; k < 3; k++) {
+          if (m_Grid[i][k] < m_Grid[e[2 * k]][k]) e[2 * k] = i;
+          if (m_Grid[i][k] > m_Grid[e[2 * k + 1]][k]) e[2 * k + 1] = i;
+        }
+      }
+    });
+
+    std::array<uint32_t, 6> extreme = extremes[0];
+    for (const auto& e : extremes) {
+      for (int k = 0; k < 3; k++) {
+        if (m_Grid[e[2 * k]][k] < m_Grid[extreme[2 * k]][k]) extreme[2 * k] = e[2 * k];
+        if (m_Grid[e[2 * k + 1]][k] > m_Grid[extreme[2 * k + 1]][k]) extreme[2 * k + 1] = e[2 * k + 1];
+      }
+    }
+
+    double best = 0;
+    for (int i = 0; i < 6; i++) {
+      for (int j = i + 1; j < 6; j++) {
+        double d = 0;
+        for (int k = 0; k < 3; k++) {
+          double delta = double(m_Grid[extreme[i]][k]) - m_Grid[extreme[j]][k];
+          d += delta * delta;
+        }
+        if (d > best) {
+          best = d;
+          simplex[0] = extreme[i];
+          simplex[1] = extreme[j];
+        }
+      }
+    }
+    if (best == 0) {
+      return false;
+    }
+
+    const GridPoint& a = m_Grid[simplex[0]];
+    const GridPoint& b = m_Grid[simplex[1]];
+    double line[3] = {double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2]};
+
+    simplex[2] = Farthest([&](const GridPoint& p) {
+      double w[3] = {double(p[0]) - a[0], double(p[1]) - a[1], double(p[2]) - a[2]};
+      double c[3] = {
+        line[1] * w[2] - line[2] * w[1],
+        line[2] * w[0] - line[0] * w[2],
+        line[0] * w[1] - line[1] * w[0]
+      };
+      return c[0] * c[0] + c[1] * c[1] + c[2] * c[2];
+    });
+
+    HullFace base;
+    base.m_V[0] = simplex[0];
+    base.m_V[1] = simplex[1];
+    base.m_V[2] = simplex[2];
+    SetPlane(base);
+
+    simplex[3] = Farthest([&](const GridPoint& p) {
+      return std::fabs(base.m_Normal[0] * p[0] + base.m_Normal[1] * p[1] +
+                       base.m_Normal[2] * p[2] - base.m_Offset);
+    });
+
+    return Side(base, simplex[3]) != 0;
+  }
+
+
+  template<typename Measure>
+  uint32_t
+  Farthest(
+    Measure measure
+  ) {
+    int workers = ParallelSTL::Workers(m_Threads, m_Grid.size());
+    std::vector<std::pair<double, uint32_t>> best(workers, {-1.0, 0});
+
+    ParallelSTL::For(m_Threads, m_Grid.size(), [&](size_t begin, size_t end, int t) {
+      for (size_t i = begin; i < end; i++) {
+        double d = measure(m_Grid[i]);
+        if (d > best[t].first) {
+          best[t] = {d, uint32_t(i)};
+        }
+      }
+    });
+
+    return std::max_element(best.begin(), best.end())->second;
+  }
+
+
+  // Move each point onto the outside set of the first face it is above.
+  void
+  Assign(
+    const std::vector<uint32_t>& points,
+    const std::vector<uint32_t>& faces
+  ) {
+    if (points.size() < HULL_PARALLEL_POINTS) {
+      for (auto i : points) {
+        for (auto f : faces) {
+          if (Side(m_Faces[f], i) > 0) {
+            m_Faces[f].m_Outside.push_back(i);
+            break;
+          }
+        }
+      }
+      return;
+    }
+
+    int workers = ParallelSTL::Workers(m_Threads, points.size());
+    std::vector<std::vector<std::vector<uint32_t>>> local(
+      workers, std::vector<std::vector<uint32_t>>(faces.size()));
+
+    ParallelSTL::For(m_Threads, points.size(), [&](size_t begin, size_t end, int t) {
+      for (size_t j = begin; j < end; j++) {
+        auto i = points[j];
+        for (size_t f = 0; f < faces.size(); f++) {
+          if (Side(m_Faces[faces[f]], i) > 0) {
+            local[t][f].push_back(i);
+            break;
+          }
+        }
+      }
+    });
+
+    for (size_t f = 0; f < faces.size(); f++) {
+      auto& outside = m_Faces[faces[f]].m_Outside;
+      for (auto& part : local) {
+        outside.insert(outside.end(), part[f].begin(), part[f].end());
+      }
+    }
+  }
+
+
+  // Drop points that snapped onto the same grid position.
+  void
+  Unique(
+    std::vector<uint32_t>& indices
+  ) {
+    std::sort(indices.begin(), indices.end(), [&](uint32_t a, uint32_t b) {
+      return m_Grid[a] < m_Grid[b];
+    });
+    indices.erase(std::unique(indices.begin(), indices.end(), [&](uint32_t a, uint32_t b) {
+      return m_Grid[a] == m_Grid[b];
+    }), indices.end());
+  }
+
+
+  void
+  Furthest(
+    HullFace& face
+  ) {
+    double best = -1;
+    for (auto i : face.m_Outside) {
+      double d = Distance(face, i);
+      if (d > best) {
+        best = d;
+        face.m_Furthest = i;
+      }
+    }
+  }
+
+  const std::vector<Point>& m_Points;
+  int m_Threads;
+  std::vector<GridPoint> m_Grid;
+  std::vector<HullFace> m_Faces;
+};
+
+
+bool
+ConvexHull(
+  const std::vector<Point>& points,
+  std::vector<Face>& faces,
+  int threads
+) {
+  Builder builder(points, threads);
+  return builder.Build(faces);
+}
+
+
+double
+Volume(
+  const std::vector<Point>& points,
+  const std::vector<Face>& faces
+) {
+  double volume = 0;
+  for (const auto& face : faces) {
+    const Point& a = points[face[0]];
+    const Point& b = points[face[1]];
+    const Point& c = points[face[2]];
+    volume += double(a[0]) * (double(b[1]) * c[2] - double(b[2]) * c[1]) +
+              double(a[1]) * (double(b[2]) * c[0] - double(b[0]) * c[2]) +
+              double(a[2]) * (double(b[0]) * c[1] - double(b[1]) * c[0]);
+  }
+  return volume / 6;
+}
+
+
+} /* namespace HullSTL */
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+namespace HullSTL {
+
+
+using Point = std::array<float, 3>;
+using Face  = std::array<uint32_t, 3>;
+
+
+// Quickhull over points.  Faces index into points, wound counter-clockwise
+// seen from outside.  Orientation tests are exact on points snapped to a
+// 2^24 grid over the bounding box; points sharing a grid position count
+// once.  Points are assigned to faces in parallel.
+// Returns false (and no faces) for degenerate, flat or collinear, input.
+bool
+ConvexHull(
+  const std::vector<Point>& points,
+  std::vector<Face>& faces,
+  int threads
+);
+
+
+// Enclosed volume of a closed, consistently wound triangle mesh.
+double
+Volume(
+  const std::vector<Point>& points,
+  const std::vector<Face>& faces
+);
+
+
+} /* namespace HullSTL */
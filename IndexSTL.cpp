@@ -0,0 +1,226 @@
+#include "IndexSTL.hpp"
+
+#include <cmath>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "STLBIfc.hpp"
+#include "ParallelSTL.hpp"
+
+#define INDEX_MAGIC     0x58444e49u   // "INDX"
+#define INDEX_VERSION   2
+#define INDEX_STL_HEADER 84           // 80 byte comment and the facet count.
+
+
+namespace IndexSTL {
+
+
+#pragma pack(push, 1)
+  typedef struct
+  IndexHeader {
+    uint32_t  m_Magic;
+    uint32_t  m_Version;
+    uint64_t  m_Size;
+    int64_t   m_Modified;
+    uint64_t  m_Facets;
+    uint64_t  m_Chunk;
+    float     m_Bounds[6];
+  } IndexHeaderT;
+#pragma pack(pop)
+
+
+std::string
+Sidecar(
+  const std::string& filename
+) {
+  return filename + ".idx";
+}
+
+
+static bool
+Stat(
+  int fd,
+  uint64_t& size,
+  int64_t& modified
+) {
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    return false;
+  }
+  size = st.st_size;
+  modified = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+  return true;
+}
+
+
+static void
+Extend(
+  Box& box,
+  const float (&v)[3]
+) {
+  for (int k = 0; k < 3; k++) {
+    box[2 * k] = std::min(box[2 * k], v[k]);
+    box[2 * k + 1] = std::max(box[2 * k + 1], v[k]);
+  }
+}
+
+
+static void
+Merge(
+  Box& box,
+  const Box& other
+) {
+  for (int k = 0; k < 3; k++) {
+    box[2 * k] = std::min(box[2 * k], other[2 * k]);
+    box[2 * k + 1] = std::max(box[2 * k + 1], other[2 * k + 1]);
+  }
+}
+
+
+bool
+Load(
+  const std::string& filename,
+  IndexT& index
+) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  uint64_t size = 0;
+  int64_t modified = 0;
+  bool stat = Stat(fd, size, modified);
+  close(fd);
+
+  std::ifstream input{Sidecar(filename), std::ios::binary | std::ios::in};
+  IndexHeaderT header;
+  input.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!stat || !input || header.m_Magic != INDEX_MAGIC || header.m_Version != INDEX_VERSION ||
+      header.m_Chunk != CHUNK || header.m_Size != size || header.m_Modified != modified ||
+      header.m_Size < INDEX_STL_HEADER ||
+      header.m_Facets * sizeof(STLFacetT) != header.m_Size - INDEX_STL_HEADER) {
+    return false;
+  }
+
+  index.m_Size = header.m_Size;
+  index.m_Modified = header.m_Modified;
+  index.m_Facets = header.m_Facets;
+  std::copy(header.m_Bounds, header.m_Bounds + 6, index.m_Bounds.begin());
+  index.m_Chunks.resize((header.m_Facets + CHUNK - 1) / CHUNK);
+  input.read(reinterpret_cast<char*>(index.m_Chunks.data()), index.m_Chunks.size() * sizeof(Box));
+
+  return bool(input);
+}
+
+
+static bool
+Build(
+  const std::string& filename,
+  int threads,
+  IndexT& index
+) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  bool valid = Stat(fd, index.m_Size, index.m_Modified) && index.m_Size >= INDEX_STL_HEADER;
+  void* map = valid ? mmap(nullptr, index.m_Size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  madvise(map, index.m_Size, MADV_SEQUENTIAL);
+
+  auto bytes = static_cast<const char*>(map);
+  uint32_t facets;
+  std::memcpy(&facets, bytes + 80, sizeof(facets));
+  if (index.m_Size != INDEX_STL_HEADER + uint64_t(facets) * sizeof(STLFacetT)) {
+    munmap(map, index.m_Size);
+    return false;
+  }
+
+  index.m_Facets = facets;
+
+  const Box empty = { HUGE_VALF, -HUGE_VALF, HUGE_VALF, -HUGE_VALF, HUGE_VALF, -HUGE_VALF };
+  auto facet = reinterpret_cast<const STLFacetT*>(bytes + INDEX_STL_HEADER);
+  index.m_Chunks.assign((facets + CHUNK - 1) / CHUNK, empty);
+
+  ParallelSTL::For(threads, index.m_Chunks.size(), [&](size_t begin, size_t end, int) {
+    for (size_t c = begin; c < end; c++) {
+      auto& box = index.m_Chunks[c];
+      for (size_t i = c * CHUNK; i < std::min<size_t>(facets, (c + 1) * CHUNK); i++) {
+        Extend(box, facet[i].m_Vertex1);
+        Extend(box, facet[i].m_Vertex2);
+        Extend(box, facet[i].m_Vertex3);
+      }
+    }
+  }, 16);
+
+  munmap(map, index.m_Size);
+
+  index.m_Bounds = facets ? empty : Box{};
+  for (auto& box : index.m_Chunks) {
+    Merge(index.m_Bounds, box);
+  }
+  return true;
+}
+
+
+static bool
+Save(
+  const std::string& filename,
+  const IndexT& index
+) {
+  auto sidecar = Sidecar(filename);
+  std::ostringstream temporary;
+  temporary << sidecar << "." << getpid() << "." << std::this_thread::get_id();
+
+  IndexHeaderT header = {
+    INDEX_MAGIC, INDEX_VERSION, index.m_Size, index.m_Modified,
+    index.m_Facets, CHUNK, {}
+  };
+  std::copy(index.m_Bounds.begin(), index.m_Bounds.end(), header.m_Bounds);
+
+  std::ofstream output{temporary.str(), std::ios::binary | std::ios::out};
+  output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  output.write(reinterpret_cast<const char*>(index.m_Chunks.data()),
+               index.m_Chunks.size() * sizeof(Box));
+  output.close();
+
+  if (!output || rename(temporary.str().c_str(), sidecar.c_str()) != 0) {
+    unlink(temporary.str().c_str());
+    return false;
+  }
+
+  return true;
+}
+
+
+bool
+Update(
+  const std::string& filename,
+  int threads,
+  IndexT& index
+) {
+  if (Load(filename, index)) {
+    return true;
+  }
+
+  if (!Build(filename, threads, index)) {
+    return false;
+  }
+
+  // A read-only directory only costs the next run a rebuild.
+  Save(filename, index);
+  return true;
+}
+
+
+} /* namespace IndexSTL */
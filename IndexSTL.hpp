@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace IndexSTL {
+
+
+// Bounds as { xMin, xMax, yMin, yMax, zMin, zMax }.
+using Box = std::array<float, 6>;
+
+
+typedef struct
+Index {
+  uint64_t          m_Size;
+  int64_t           m_Modified; // Nanoseconds.
+  uint64_t          m_Facets;
+  Box               m_Bounds;
+  std::vector<Box>  m_Chunks;   // One per CHUNK facets, in file order.
+                                // Reserved: written for clips and filters
+                                // to pass over chunks, not read yet.
+} IndexT;
+
+
+// Facets per chunk box.
+constexpr size_t CHUNK = 4096;
+
+
+// Sidecar written next to filename.
+std::string
+Sidecar(
+  const std::string& filename
+);
+
+
+// Read the sidecar of filename; false if it is missing, damaged, its facet
+// count does not fit the file's size, or the file's size or modification
+// time no longer match.  The contents are not rehashed, so an edit that
+// keeps both goes unnoticed.
+bool
+Load(
+  const std::string& filename,
+  IndexT& index
+);
+
+
+// Load the sidecar, or build it by mapping filename and scanning chunks in
+// parallel, then write it.  False if filename is not a valid binary STL.
+bool
+Update(
+  const std::string& filename,
+  int threads,
+  IndexT& index
+);
+
+
+} /* namespace IndexSTL */
@@ -0,0 +1,199 @@
+#include "stool.h"
+
+#include <new>
+#include <cstring>
+#include <exception>
+#include <unistd.h>
+
+#include "STLBIfc.hpp"
+#include "OpsSTL.hpp"
+
+
+static_assert(sizeof(stool_facet) == sizeof(STLFacetT), "stool_facet must match STLFacetT");
+static_assert(STOOL_HEADER_SIZE == 80 + sizeof(uint32_t), "STOOL_HEADER_SIZE must match the STLB header");
+
+
+struct
+stool_object {
+  stool_object(const std::string& filename, int threads) : m_Object(filename, threads) {}
+  stool_object(const void* data, size_t length, int threads) : m_Object(data, length, threads) {}
+
+  STLBObj m_Object;
+};
+
+
+static void
+Error(
+  char* error,
+  size_t error_length,
+  const char* message
+) {
+  if (error && error_length) {
+    std::strncpy(error, message, error_length - 1);
+    error[error_length - 1] = '\0';
+  }
+}
+
+
+// Nothing may throw across the C interface.
+template<typename Create>
+static stool_object*
+Make(
+  Create&& create
+) {
+  try {
+    stool_object* object = create();
+    if (!object->m_Object.Valid()) {
+      delete object;
+      return nullptr;
+    }
+    return object;
+  } catch (const std::exception&) {
+    return nullptr;
+  }
+}
+
+
+extern "C" {
+
+
+unsigned
+stool_abi_version(void) {
+  return STOOL_ABI_VERSION;
+}
+
+
+stool_object*
+stool_open(
+  const char* filename,
+  int threads
+) {
+  if (!filename || access(filename, R_OK) != 0) {
+    return nullptr;
+  }
+  return Make([&] { return new stool_object(filename, threads); });
+}
+
+
+stool_object*
+stool_load(
+  const void* data,
+  size_t length,
+  int threads
+) {
+  if (!data || length < STOOL_HEADER_SIZE) {
+    return nullptr;
+  }
+  return Make([&] { return new stool_object(data, length, threads); });
+}
+
+
+void
+stool_free(
+  stool_object* object
+) {
+  delete object;
+}
+
+
+int
+stool_apply(
+  stool_object* object,
+  const char* operations,
+  char* error,
+  size_t error_length
+) {
+  if (!object || !operations) {
+    Error(error, error_length, "Expected an object and operations.");
+    return -1;
+  }
+
+  try {
+    OpsSTL::Chain(object->m_Object, operations);
+  } catch (const std::exception& ex) {
+    Error(error, error_length, ex.what());
+    return -1;
+  }
+  return 0;
+}
+
+
+stool_facets
+stool_view(
+  stool_object* object
+) {
+  stool_facets view = { nullptr, 0 };
+  if (object) {
+    view.data = reinterpret_cast<const stool_facet*>(object->m_Object.Facets(view.count));
+  }
+  return view;
+}
+
+
+stool_bytes
+stool_image(
+  stool_object* object
+) {
+  stool_bytes image = { nullptr, 0 };
+  if (object) {
+    image.data = object->m_Object.Data();
+    image.length = object->m_Object.Bytes();
+  }
+  return image;
+}
+
+
+int
+stool_minmax(
+  stool_object* object,
+  float bounds[6]
+) {
+  size_t count = 0;
+  if (!object || !bounds || (object->m_Object.Facets(count), count == 0)) {
+    return -1;
+  }
+
+  float x[2], y[2], z[2];
+  object->m_Object.MinMax(x, y, z);
+  bounds[0] = x[0]; bounds[1] = x[1];
+  bounds[2] = y[0]; bounds[3] = y[1];
+  bounds[4] = z[0]; bounds[5] = z[1];
+  return 0;
+}
+
+
+int
+stool_query(
+  stool_object* object,
+  const float* points,
+  size_t count,
+  float* distances
+) {
+  if (!object || (count && (!points || !distances))) {
+    return -1;
+  }
+  try {
+    return object->m_Object.Query(points, count, distances) ? 0 : -1;
+  } catch (const std::exception&) {
+    return -1;
+  }
+}
+
+
+int
+stool_save(
+  stool_object* object,
+  const char* filename
+) {
+  if (!object || !filename) {
+    return -1;
+  }
+  try {
+    return object->m_Object.Save(filename) ? 0 : -1;
+  } catch (const std::exception&) {
+    return -1;
+  }
+}
+
+
+} /* extern "C" */
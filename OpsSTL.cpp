@@ -0,0 +1,107 @@
+#include "OpsSTL.hpp"
+
+#include <cmath>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace OpsSTL {
+
+
+typedef struct
+Operation {
+  std::string m_Name;
+  float       m_Vector[3];
+} OperationT;
+
+
+static void
+ParseVector(
+  const std::string& value,
+  float (&xyz)[3]
+) {
+  std::istringstream ss(value);
+  std::string token;
+  std::vector<std::string> coordinate;
+  while (std::getline(ss, token, ',')) {
+    coordinate.push_back(token);
+  }
+
+  if (coordinate.size() != 3) {
+    throw std::runtime_error("Expected 3 comma separated floats: " + value);
+  }
+
+  try {
+    for (int i = 0; i < 3; i++) {
+      xyz[i] = std::stof(coordinate[i]);
+    }
+  } catch (const std::logic_error&) {
+    throw std::runtime_error("Expected 3 comma separated floats: " + value);
+  }
+}
+
+
+static OperationT
+Parse(
+  const std::string& operation
+) {
+  auto separator = operation.find('=');
+  if (separator == std::string::npos) {
+    throw std::runtime_error("Expected operation=x,y,z: " + operation);
+  }
+
+  OperationT parsed;
+  parsed.m_Name = operation.substr(0, separator);
+  if (parsed.m_Name != "rotate" && parsed.m_Name != "scale" && parsed.m_Name != "translate") {
+    throw std::runtime_error("Unknown operation: " + parsed.m_Name);
+  }
+  ParseVector(operation.substr(separator + 1), parsed.m_Vector);
+  return parsed;
+}
+
+
+static void
+Run(
+  STLBObj& object,
+  const OperationT& operation
+) {
+  auto& xyz = operation.m_Vector;
+  if (operation.m_Name == "rotate") {
+    object.Rotate(xyz[0] * (M_PI/180), xyz[1] * (M_PI/180), xyz[2] * (M_PI/180));
+  } else if (operation.m_Name == "scale") {
+    object.Scale(xyz[0], xyz[1], xyz[2]);
+  } else {
+    object.Translate(xyz[0], xyz[1], xyz[2]);
+  }
+}
+
+
+void
+Apply(
+  STLBObj& object,
+  const std::string& operation
+) {
+  Run(object, Parse(operation));
+}
+
+
+void
+Chain(
+  STLBObj& object,
+  const std::string& operations
+) {
+  std::istringstream ss(operations);
+  std::vector<OperationT> parsed;
+  std::string token;
+  while (ss >> token) {
+    parsed.push_back(Parse(token));
+  }
+
+  for (auto& operation : parsed) {
+    Run(object, operation);
+  }
+}
+
+
+} /* namespace OpsSTL */
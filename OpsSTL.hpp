@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+#include "STLBIfc.hpp"
+
+namespace OpsSTL {
+
+
+// Apply one operation, in the form the server's transform command takes:
+//
+//   rotate=x,y,z      (DEGREES)
+//   scale=x,y,z
+//   translate=x,y,z
+//
+// Throws std::runtime_error on a malformed or unknown operation.
+void
+Apply(
+  STLBObj& object,
+  const std::string& operation
+);
+
+
+// Apply whitespace separated operations in order.  Every operation is
+// checked before the first one runs, so a bad chain leaves object as it was.
+void
+Chain(
+  STLBObj& object,
+  const std::string& operations
+);
+
+
+} /* namespace OpsSTL */
@@ -0,0 +1,311 @@
+#include "OrientSTL.hpp"
+
+#include <cmath>
+#include <atomic>
+#include <numeric>
+#include <algorithm>
+
+#include "ParallelSTL.hpp"
+
+#define ORIENT_BLOCK_SIZE 1024
+#define ORIENT_LANES      8
+
+namespace OrientSTL {
+
+
+using Direction = std::array<double, 3>;
+
+
+// Facets as structure of arrays, largest first, so the kernel streams
+// through contiguous floats and partial scores grow quickly.
+struct
+Facets {
+  std::vector<float> m_N[3];    // Area weighted normal.
+  std::vector<float> m_C[3];    // Centroid.
+  std::vector<float> m_Area;
+  size_t             m_Count = 0;
+};
+
+
+static void
+Prepare(
+  const std::vector<HullSTL::Point>& corners,
+  int threads,
+  Facets& facets
+) {
+  size_t count = corners.size() / 3;
+  std::vector<float> area(count);
+
+  ParallelSTL::For(threads, count, [&](size_t begin, size_t end, int) {
+    for (size_t i = begin; i < end; i++) {
+      auto& a = corners[3 * i];
+      auto& b = corners[3 * i + 1];
+      auto& c = corners[3 * i + 2];
+      float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+      float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+      float n[3] = { e1[1] * e2[2] - e1[2] * e2[1],
+                     e1[2] * e2[0] - e1[0] * e2[2],
+                     e1[0] * e2[1] - e1[1] * e2[0] };
+      area[i] = 0.5f * std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    }
+  });
+
+  std::vector<uint32_t> order(count);
+  std::iota(order.begin(), order.end(), 0);
+  order.erase(std::remove_if(order.begin(), order.end(),
+                             [&](uint32_t i) { return !(area[i] > 0); }), order.end());
+  std::stable_sort(order.begin(), order.end(),
+                   [&](uint32_t i, uint32_t j) { return area[i] > area[j]; });
+
+  facets.m_Count = order.size();
+  for (int k = 0; k < 3; k++) {
+    facets.m_N[k].resize(facets.m_Count);
+    facets.m_C[k].resize(facets.m_Count);
+  }
+  facets.m_Area.resize(facets.m_Count);
+
+  ParallelSTL::For(threads, facets.m_Count, [&](size_t begin, size_t end, int) {
+    for (size_t j = begin; j < end; j++) {
+      size_t i = order[j];
+      auto& a = corners[3 * i];
+      auto& b = corners[3 * i + 1];
+      auto& c = corners[3 * i + 2];
+      float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+      float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+      facets.m_N[0][j] = 0.5f * (e1[1] * e2[2] - e1[2] * e2[1]);
+      facets.m_N[1][j] = 0.5f * (e1[2] * e2[0] - e1[0] * e2[2]);
+      facets.m_N[2][j] = 0.5f * (e1[0] * e2[1] - e1[1] * e2[0]);
+      for (int k = 0; k < 3; k++) {
+        facets.m_C[k][j] = (a[k] + b[k] + c[k]) / 3.0f;
+      }
+      facets.m_Area[j] = area[i];
+    }
+  });
+}
+
+
+// The up direction, in the unrotated frame, after Rotate(x, y, z): the last
+// row of Rz.Ry.Rx, which Rz leaves alone.
+static Direction
+Up(
+  double x,
+  double y
+) {
+  return { -std::sin(y), std::cos(y) * std::sin(x), std::cos(y) * std::cos(x) };
+}
+
+
+static void
+Angles(
+  const Direction& d,
+  float (&angle)[2]
+) {
+  angle[0] = std::atan2(d[1], d[2]);
+  angle[1] = std::asin(std::clamp(-d[0], -1.0, 1.0));
+}
+
+
+// The current orientation, the largest hull faces put down on the bed, then
+// a Fibonacci spiral over the sphere.
+static std::vector<Direction>
+Candidates(
+  const std::vector<HullSTL::Point>& points,
+  const std::vector<HullSTL::Face>& faces,
+  size_t count
+) {
+  std::vector<Direction> directions;
+  directions.push_back(Up(0, 0));
+
+  std::vector<std::pair<double, Direction>> down;
+  for (auto& face : faces) {
+    auto& a = points[face[0]];
+    auto& b = points[face[1]];
+    auto& c = points[face[2]];
+    double e1[3] = { double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2] };
+    double e2[3] = { double(c[0]) - a[0], double(c[1]) - a[1], double(c[2]) - a[2] };
+    Direction n = { e1[1] * e2[2] - e1[2] * e2[1],
+                    e1[2] * e2[0] - e1[0] * e2[2],
+                    e1[0] * e2[1] - e1[1] * e2[0] };
+    double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (length > 0) {
+      down.push_back({ length, { -n[0] / length, -n[1] / length, -n[2] / length } });
+    }
+  }
+
+  size_t nFaces = std::min(down.size(), count / 2);
+  std::partial_sort(down.begin(), down.begin() + nFaces, down.end(),
+                    [](auto& p, auto& q) { return p.first > q.first; });
+  for (size_t i = 0; i < nFaces; i++) {
+    directions.push_back(down[i].second);
+  }
+
+  size_t spread = count > directions.size() ? count - directions.size() : 0;
+  double golden = M_PI * (3.0 - std::sqrt(5.0));
+  for (size_t i = 0; i < spread; i++) {
+    double z = 1.0 - 2.0 * (i + 0.5) / spread;
+    double r = std::sqrt(std::max(0.0, 1.0 - z * z));
+    directions.push_back({ r * std::cos(golden * i), r * std::sin(golden * i), z });
+  }
+
+  return directions;
+}
+
+
+static void
+Lower(
+  std::atomic<double>& bound,
+  double score
+) {
+  double current = bound.load(std::memory_order_relaxed);
+  while (score < current &&
+         !bound.compare_exchange_weak(current, score, std::memory_order_relaxed)) {
+  }
+}
+
+
+OrientationT
+Optimize(
+  const std::vector<HullSTL::Point>& corners,
+  size_t candidates,
+  int threads
+) {
+  OrientationT best = { { 0, 0 }, 0, 0, 0, 0 };
+  if (corners.size() < 3) {
+    return best;
+  }
+
+  // Z extent only depends on the hull; fall back to every corner when the
+  // mesh is flat.
+  std::vector<HullSTL::Face> faces;
+  std::vector<HullSTL::Point> extremes;
+  if (HullSTL::ConvexHull(corners, faces, threads)) {
+    std::vector<uint32_t> used;
+    for (auto& face : faces) {
+      used.insert(used.end(), face.begin(), face.end());
+    }
+    std::sort(used.begin(), used.end());
+    used.erase(std::unique(used.begin(), used.end()), used.end());
+    for (auto i : used) {
+      extremes.push_back(corners[i]);
+    }
+  } else {
+    extremes = corners;
+  }
+
+  double lo[3], hi[3];
+  for (int k = 0; k < 3; k++) {
+    lo[k] = hi[k] = extremes[0][k];
+  }
+  for (auto& p : extremes) {
+    for (int k = 0; k < 3; k++) {
+      lo[k] = std::min<double>(lo[k], p[k]);
+      hi[k] = std::max<double>(hi[k], p[k]);
+    }
+  }
+  double L = std::sqrt((hi[0] - lo[0]) * (hi[0] - lo[0]) +
+                       (hi[1] - lo[1]) * (hi[1] - lo[1]) +
+                       (hi[2] - lo[2]) * (hi[2] - lo[2]));
+  if (!(L > 0)) {
+    return best;
+  }
+
+  Facets facets;
+  Prepare(corners, threads, facets);
+
+  auto directions = Candidates(corners, faces, std::max<size_t>(candidates, 1));
+
+  const float steep = std::cos(M_PI / 4);
+  const float bed = 1e-4 * L;
+  std::atomic<double> bound{ HUGE_VAL };
+
+  int nWorkers = ParallelSTL::Workers(threads, directions.size(), 1);
+  std::vector<OrientationT> bests(nWorkers);
+  std::vector<size_t> winners(nWorkers, directions.size());
+
+  ParallelSTL::For(threads, directions.size(), [&](size_t begin, size_t end, int thread) {
+    for (size_t c = begin; c < end; c++) {
+      const auto& d = directions[c];
+
+      double zMin = HUGE_VAL, zMax = -HUGE_VAL;
+      for (auto& p : extremes) {
+        double z = p[0] * d[0] + p[1] * d[1] + p[2] * d[2];
+        zMin = std::min(zMin, z);
+        zMax = std::max(zMax, z);
+      }
+
+      double height = zMax - zMin;
+      double overhang = 0, support = 0;
+      double score = height / L;
+      if (score > bound.load(std::memory_order_relaxed)) {
+        continue;
+      }
+
+      const float dx = d[0], dy = d[1], dz = d[2], floor = zMin + bed;
+      bool rejected = false;
+
+      for (size_t b = 0; b < facets.m_Count && !rejected; b += ORIENT_BLOCK_SIZE) {
+        size_t e = std::min(facets.m_Count, b + ORIENT_BLOCK_SIZE);
+        float area[ORIENT_LANES] = {};
+        float volume[ORIENT_LANES] = {};
+
+        size_t i = b;
+        for (; i + ORIENT_LANES <= e; i += ORIENT_LANES) {
+          for (int k = 0; k < ORIENT_LANES; k++) {
+            float a = facets.m_N[0][i + k] * dx + facets.m_N[1][i + k] * dy +
+                      facets.m_N[2][i + k] * dz;
+            float z = facets.m_C[0][i + k] * dx + facets.m_C[1][i + k] * dy +
+                      facets.m_C[2][i + k] * dz;
+            bool down = (a < -steep * facets.m_Area[i + k]) & (z > floor);
+            area[k] += down ? facets.m_Area[i + k] : 0.0f;
+            volume[k] += down ? -a * (z - zMin) : 0.0f;
+          }
+        }
+        for (; i < e; i++) {
+          float a = facets.m_N[0][i] * dx + facets.m_N[1][i] * dy + facets.m_N[2][i] * dz;
+          float z = facets.m_C[0][i] * dx + facets.m_C[1][i] * dy + facets.m_C[2][i] * dz;
+          if (a < -steep * facets.m_Area[i] && z > floor) {
+            area[0] += facets.m_Area[i];
+            volume[0] += -a * (z - zMin);
+          }
+        }
+
+        for (int k = 0; k < ORIENT_LANES; k++) {
+          overhang += area[k];
+          support += volume[k];
+        }
+
+        score = height / L + overhang / (L * L) + support / (L * L * L);
+        rejected = score > bound.load(std::memory_order_relaxed);
+      }
+
+      if (rejected) {
+        continue;
+      }
+
+      Lower(bound, score);
+      if (winners[thread] == directions.size() || score < bests[thread].m_Score) {
+        winners[thread] = c;
+        bests[thread] = { { 0, 0 }, overhang, support, height, score };
+      }
+    }
+  }, 1);
+
+  // Lowest score, then lowest candidate, so the pick is thread independent.
+  size_t winner = directions.size();
+  for (int t = 0; t < nWorkers; t++) {
+    if (winners[t] == directions.size()) {
+      continue;
+    }
+    if (winner == directions.size() || bests[t].m_Score < best.m_Score ||
+        (bests[t].m_Score == best.m_Score && winners[t] < winner)) {
+      winner = winners[t];
+      best = bests[t];
+    }
+  }
+
+  Angles(directions[winner], best.m_Angle);
+  return best;
+}
+
+
+} /* namespace OrientSTL */
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "HullSTL.hpp"
+
+namespace OrientSTL {
+
+
+typedef struct
+Orientation {
+  float     m_Angle[2];     // X then Y rotation (RADIANS), as taken by Rotate.
+  double    m_Overhang;     // Area facing down steeper than 45 degrees.
+  double    m_Support;      // Volume between those facets and the bed.
+  double    m_Height;       // Z extent.
+  double    m_Score;
+} OrientationT;
+
+
+// Score candidate print orientations of a mesh given as three corners per
+// facet and return the best.  Only the up direction matters to the score, so
+// candidates are directions: the current one, the inward normals of the
+// largest hull faces, then an even spread over the sphere.  Each is scored
+// as Height/L + Overhang/L^2 + Support/L^3, L the bounding box diagonal, by
+// dot products against precomputed facet normals and centroids; no vertex is
+// rotated.  Candidates run in parallel and are dropped as soon as their
+// partial score exceeds the best so far.  The result does not depend on the
+// number of threads.
+OrientationT
+Optimize(
+  const std::vector<HullSTL::Point>& corners,
+  size_t candidates,
+  int threads
+);
+
+
+} /* namespace OrientSTL */
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+namespace ParallelSTL {
+
+
+// Split [0, count) into contiguous ranges, one per thread, and call
+// work(begin, end, thread) for each.  Small ranges run on the caller.
+template<typename Work>
+void
+For(
+  int threads,
+  size_t count,
+  Work&& work,
+  size_t grain = 4096
+) {
+  size_t n = std::max<size_t>(1, std::min<size_t>(
+    std::max(threads, 1), (count + grain - 1) / grain));
+
+  if (n == 1) {
+    work(size_t(0), count, 0);
+    return;
+  }
+
+  std::vector<std::thread> workers;
+  size_t step = (count + n - 1) / n;
+  for (size_t t = 1; t < n; t++) {
+    size_t begin = std::min(count, t * step);
+    size_t end = std::min(count, begin + step);
+    workers.emplace_back([&work, begin, end, t] { work(begin, end, int(t)); });
+  }
+
+  work(size_t(0), std::min(count, step), 0);
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+
+// Number of workers For() will use for count items.
+inline int
+Workers(
+  int threads,
+  size_t count,
+  size_t grain = 4096
+) {
+  return int(std::max<size_t>(1, std::min<size_t>(
+    std::max(threads, 1), (count + grain - 1) / grain)));
+}
+
+
+} /* namespace ParallelSTL */
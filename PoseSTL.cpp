@@ -0,0 +1,425 @@
+#include "PoseSTL.hpp"
+
+#include <cmath>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include "STLBIfc.hpp"
+
+#define POSE_JACOBI_SWEEPS  32
+#define POSE_RELATIVE       1e-3
+
+
+namespace PoseSTL {
+
+
+using Vec = std::array<double, 3>;
+
+
+static inline Vec
+Vertex(
+  const float (&v)[3]
+) {
+  return {v[0], v[1], v[2]};
+}
+
+
+static inline double
+Dot(const Vec& a, const Vec& b) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+
+static inline Vec
+Cross(const Vec& a, const Vec& b) {
+  return {a[1] * b[2] - a[2] * b[1],
+          a[2] * b[0] - a[0] * b[2],
+          a[0] * b[1] - a[1] * b[0]};
+}
+
+
+// Eigenvalues d and eigenvectors (columns of v) of symmetric a, by cyclic
+// Jacobi rotations; a is left diagonalized.
+static void
+Jacobi(
+  double (&a)[3][3],
+  double (&v)[3][3],
+  double (&d)[3]
+) {
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      v[i][j] = i == j;
+    }
+  }
+
+  for (int sweep = 0; sweep < POSE_JACOBI_SWEEPS; sweep++) {
+    double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+    double diagonal = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+    if (off <= 1e-30 * diagonal) {
+      break;
+    }
+
+    for (int p = 0; p < 2; p++) {
+      for (int q = p + 1; q < 3; q++) {
+        if (a[p][q] == 0) {
+          continue;
+        }
+        double theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+        double t = (theta >= 0 ? 1 : -1) / (std::fabs(theta) + std::sqrt(theta * theta + 1));
+        double c = 1 / std::sqrt(t * t + 1), s = t * c;
+
+        for (int k = 0; k < 3; k++) {
+          double kp = a[k][p], kq = a[k][q];
+          a[k][p] = c * kp - s * kq;
+          a[k][q] = s * kp + c * kq;
+        }
+        for (int k = 0; k < 3; k++) {
+          double pk = a[p][k], qk = a[q][k];
+          a[p][k] = c * pk - s * qk;
+          a[q][k] = s * pk + c * qk;
+        }
+        for (int k = 0; k < 3; k++) {
+          double kp = v[k][p], kq = v[k][q];
+          v[k][p] = c * kp - s * kq;
+          v[k][q] = s * kp + c * kq;
+        }
+      }
+    }
+  }
+
+  for (int k = 0; k < 3; k++) {
+    d[k] = a[k][k];
+  }
+}
+
+
+PoseT
+Normalize(
+  const STLFacet* facets,
+  const uint32_t* members,
+  size_t count
+) {
+  PoseT pose = {};
+  pose.m_Facets = count;
+
+  double area = 0;
+  Vec volumeCenter = {0, 0, 0}, areaCenter = {0, 0, 0};
+  for (size_t i = 0; i < count; i++) {
+    const auto& f = facets[members[i]];
+    Vec a = Vertex(f.m_Vertex1), b = Vertex(f.m_Vertex2), c = Vertex(f.m_Vertex3);
+    Vec n = Cross({b[0] - a[0], b[1] - a[1], b[2] - a[2]}, {c[0] - a[0], c[1] - a[1], c[2] - a[2]});
+    double A = std::sqrt(Dot(n, n)) / 2;
+    double V = Dot(a, Cross(b, c)) / 6;
+    area += A;
+    pose.m_Volume += V;
+    for (int k = 0; k < 3; k++) {
+      volumeCenter[k] += V * (a[k] + b[k] + c[k]) / 4;
+      areaCenter[k] += A * (a[k] + b[k] + c[k]) / 3;
+    }
+  }
+
+  bool solid = std::fabs(pose.m_Volume) > 1e-9 * area * std::sqrt(area);
+  for (int k = 0; k < 3; k++) {
+    pose.m_Center[k] = solid ? volumeCenter[k] / pose.m_Volume
+                     : area > 0 ? areaCenter[k] / area : 0;
+  }
+  if (!(area > 0)) {
+    for (int k = 0; k < 3; k++) {
+      pose.m_Axes[k][k] = 1;
+    }
+    return pose;
+  }
+
+  // Surface covariance about the center: over a triangle, the integral of
+  // x x^T is A/12 (a a^T + b b^T + c c^T + s s^T), s = a + b + c.
+  double covariance[3][3] = {};
+  for (size_t i = 0; i < count; i++) {
+    const auto& f = facets[members[i]];
+    Vec v[3] = { Vertex(f.m_Vertex1), Vertex(f.m_Vertex2), Vertex(f.m_Vertex3) };
+    for (auto& p : v) {
+      for (int k = 0; k < 3; k++) {
+        p[k] -= pose.m_Center[k];
+      }
+    }
+    Vec n = Cross({v[1][0] - v[0][0], v[1][1] - v[0][1], v[1][2] - v[0][2]},
+                  {v[2][0] - v[0][0], v[2][1] - v[0][1], v[2][2] - v[0][2]});
+    double A = std::sqrt(Dot(n, n)) / 2;
+    Vec s = {v[0][0] + v[1][0] + v[2][0], v[0][1] + v[1][1] + v[2][1], v[0][2] + v[1][2] + v[2][2]};
+    for (int r = 0; r < 3; r++) {
+      for (int c = 0; c < 3; c++) {
+        covariance[r][c] += A / 12 * (v[0][r] * v[0][c] + v[1][r] * v[1][c] +
+                                      v[2][r] * v[2][c] + s[r] * s[c]);
+      }
+    }
+  }
+  for (auto& row : covariance) {
+    for (auto& c : row) {
+      c /= area;
+    }
+  }
+
+  double vectors[3][3], moments[3];
+  Jacobi(covariance, vectors, moments);
+
+  int order[3] = {0, 1, 2};
+  std::sort(order, order + 3, [&](int a, int b) { return moments[a] > moments[b]; });
+  Vec axes[3];
+  for (int k = 0; k < 3; k++) {
+    pose.m_Moments[k] = moments[order[k]];
+    axes[k] = {vectors[0][order[k]], vectors[1][order[k]], vectors[2][order[k]]};
+  }
+
+  // Third moments, from triangle centroids, choose each axis' direction.
+  double skew[2] = {0, 0};
+  for (size_t i = 0; i < count; i++) {
+    const auto& f = facets[members[i]];
+    Vec a = Vertex(f.m_Vertex1), b = Vertex(f.m_Vertex2), c = Vertex(f.m_Vertex3);
+    Vec n = Cross({b[0] - a[0], b[1] - a[1], b[2] - a[2]}, {c[0] - a[0], c[1] - a[1], c[2] - a[2]});
+    double A = std::sqrt(Dot(n, n)) / 2;
+    Vec m;
+    for (int k = 0; k < 3; k++) {
+      m[k] = (a[k] + b[k] + c[k]) / 3 - pose.m_Center[k];
+    }
+    for (int k = 0; k < 2; k++) {
+      double x = Dot(m, axes[k]);
+      skew[k] += A * x * x * x;
+    }
+  }
+  for (int k = 0; k < 2; k++) {
+    if (skew[k] < 0) {
+      axes[k] = {-axes[k][0], -axes[k][1], -axes[k][2]};
+    }
+  }
+  axes[2] = Cross(axes[0], axes[1]);
+
+  for (int k = 0; k < 3; k++) {
+    std::copy(axes[k].begin(), axes[k].end(), pose.m_Axes[k]);
+  }
+  return pose;
+}
+
+
+static inline bool
+Close(
+  double a,
+  double b,
+  double tolerance
+) {
+  return std::fabs(a - b) <= POSE_RELATIVE * std::max(std::fabs(a), std::fabs(b)) + tolerance;
+}
+
+
+long
+Step(
+  const PoseT& pose,
+  double tolerance
+) {
+  // Close volumes differ by at most POSE_RELATIVE (v + tolerance / POSE_RELATIVE),
+  // just over one unit of log(v + tolerance / POSE_RELATIVE) / POSE_RELATIVE.
+  return long(std::floor(std::log(std::fabs(pose.m_Volume) + tolerance / POSE_RELATIVE) /
+                         (2 * POSE_RELATIVE)));
+}
+
+
+// Facets of an object bucketed by centroid on a grid of tolerance, so a
+// facet within tolerance of another is found in the 27 cells around it.
+class Grid {
+public:
+  Grid(
+    const STLFacet* facets,
+    const uint32_t* members,
+    size_t count,
+    double tolerance
+  ) : m_Facets(facets), m_Members(members), m_Tolerance(tolerance),
+      m_Used(count, 0) {
+    for (size_t i = 0; i < count; i++) {
+      const auto& f = facets[members[i]];
+      Vec v[3] = { Vertex(f.m_Vertex1), Vertex(f.m_Vertex2), Vertex(f.m_Vertex3) };
+      m_Cells[Key(Centroid(v), 0, 0, 0)].push_back(i);
+    }
+  }
+
+
+  void
+  Reset() {
+    std::fill(m_Used.begin(), m_Used.end(), 0);
+  }
+
+
+  // Claim an unclaimed facet with the vertices v, in the same winding.
+  bool
+  Take(
+    const Vec (&v)[3]
+  ) {
+    Vec centroid = Centroid(v);
+    for (int dx = -1; dx <= 1; dx++) {
+      for (int dy = -1; dy <= 1; dy++) {
+        for (int dz = -1; dz <= 1; dz++) {
+          auto cell = m_Cells.find(Key(centroid, dx, dy, dz));
+          if (cell == m_Cells.end()) {
+            continue;
+          }
+          for (auto i : cell->second) {
+            if (!m_Used[i] && Same(v, m_Facets[m_Members[i]])) {
+              m_Used[i] = 1;
+              return true;
+            }
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+
+private:
+  using Cell = std::array<int64_t, 3>;
+
+  struct CellHash {
+    size_t
+    operator()(const Cell& c) const {
+      return (uint64_t(c[0]) * 0x9e3779b97f4a7c15ULL) ^
+             (uint64_t(c[1]) * 0xc2b2ae3d27d4eb4fULL) ^
+             (uint64_t(c[2]) * 0x165667b19e3779f9ULL);
+    }
+  };
+
+
+  static Vec
+  Centroid(
+    const Vec (&v)[3]
+  ) {
+    return {(v[0][0] + v[1][0] + v[2][0]) / 3, (v[0][1] + v[1][1] + v[2][1]) / 3,
+            (v[0][2] + v[1][2] + v[2][2]) / 3};
+  }
+
+
+  Cell
+  Key(
+    const Vec& p,
+    int dx,
+    int dy,
+    int dz
+  ) const {
+    return { int64_t(std::floor(p[0] / m_Tolerance)) + dx,
+             int64_t(std::floor(p[1] / m_Tolerance)) + dy,
+             int64_t(std::floor(p[2] / m_Tolerance)) + dz };
+  }
+
+
+  bool
+  Same(
+    const Vec (&v)[3],
+    const STLFacet& f
+  ) const {
+    Vec u[3] = { Vertex(f.m_Vertex1), Vertex(f.m_Vertex2), Vertex(f.m_Vertex3) };
+    for (int r = 0; r < 3; r++) {
+      bool same = true;
+      for (int i = 0; i < 3 && same; i++) {
+        for (int k = 0; k < 3 && same; k++) {
+          same = std::fabs(v[i][k] - u[(i + r) % 3][k]) <= m_Tolerance;
+        }
+      }
+      if (same) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+
+  const STLFacet*         m_Facets;
+  const uint32_t*         m_Members;
+  double                  m_Tolerance;
+  std::vector<char>       m_Used;
+  std::unordered_map<Cell, std::vector<uint32_t>, CellHash> m_Cells;
+};
+
+
+static bool
+Moves(
+  const STLFacet* facets,
+  const uint32_t* a,
+  size_t count,
+  Grid& grid,
+  const double (&rotation)[3][3],
+  const double (&translation)[3]
+) {
+  grid.Reset();
+  for (size_t i = 0; i < count; i++) {
+    const auto& f = facets[a[i]];
+    const float* from[3] = { f.m_Vertex1, f.m_Vertex2, f.m_Vertex3 };
+    Vec v[3];
+    for (int j = 0; j < 3; j++) {
+      for (int r = 0; r < 3; r++) {
+        v[j][r] = rotation[r][0] * from[j][0] + rotation[r][1] * from[j][1] +
+                  rotation[r][2] * from[j][2] + translation[r];
+      }
+    }
+    if (!grid.Take(v)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+bool
+Match(
+  const STLFacet* facets,
+  const uint32_t* a,
+  const PoseT& poseA,
+  const uint32_t* b,
+  const PoseT& poseB,
+  double tolerance,
+  double (&rotation)[3][3],
+  double (&translation)[3]
+) {
+  if (poseA.m_Facets != poseB.m_Facets || !Close(poseA.m_Volume, poseB.m_Volume, tolerance)) {
+    return false;
+  }
+  for (int k = 0; k < 3; k++) {
+    if (!Close(poseA.m_Moments[k], poseB.m_Moments[k], tolerance)) {
+      return false;
+    }
+  }
+
+  Grid grid(facets, b, poseB.m_Facets, tolerance);
+
+  // x_b = B^T S A (x_a - c_a) + c_b, with the axes as the rows of A and B.
+  // S flips pairs of axes, for parts whose third moment along an axis
+  // vanishes (a mirror symmetric part) and so leaves its direction open.
+  const double flips[4][3] = { {1, 1, 1}, {1, -1, -1}, {-1, 1, -1}, {-1, -1, 1} };
+  for (auto& flip : flips) {
+    for (int r = 0; r < 3; r++) {
+      for (int c = 0; c < 3; c++) {
+        rotation[r][c] = 0;
+        for (int k = 0; k < 3; k++) {
+          rotation[r][c] += poseB.m_Axes[k][r] * flip[k] * poseA.m_Axes[k][c];
+        }
+      }
+    }
+    for (int r = 0; r < 3; r++) {
+      translation[r] = poseB.m_Center[r];
+      for (int c = 0; c < 3; c++) {
+        translation[r] -= rotation[r][c] * poseA.m_Center[c];
+      }
+    }
+    if (Moves(facets, a, poseA.m_Facets, grid, rotation, translation)) {
+      return true;
+    }
+  }
+
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 3; c++) {
+      rotation[r][c] = r == c;
+    }
+    translation[r] = poseB.m_Center[r] - poseA.m_Center[r];
+  }
+  return Moves(facets, a, poseA.m_Facets, grid, rotation, translation);
+}
+
+
+} /* namespace PoseSTL */
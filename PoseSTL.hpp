@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+struct STLFacet;
+
+namespace PoseSTL {
+
+
+// Pose independent description of one object: where it is and how it is
+// turned, and what stays the same under any rigid motion.
+typedef struct
+Pose {
+  double  m_Center[3];    // Volume centroid, or area centroid if flat or open.
+  double  m_Axes[3][3];   // Rows: principal axes of the surface, largest
+                          // moment first, right handed.
+  double  m_Moments[3];   // Area weighted second moments about the axes.
+  double  m_Volume;
+  size_t  m_Facets;
+} PoseT;
+
+
+// Pose of the facets listed in members.  Axes come from a Jacobi
+// eigendecomposition of the surface covariance; each of the first two points
+// along the positive third moment, so a copy turned any way gets the same
+// axes relative to its geometry.
+PoseT
+Normalize(
+  const STLFacet* facets,
+  const uint32_t* members,
+  size_t count
+);
+
+
+// Volume step of a pose, on a log scale two relative tolerances wide.  Any
+// two poses Match accepts share a facet count and lie on the same or
+// neighbouring steps, so candidates can be bucketed by both.
+long
+Step(
+  const PoseT& pose,
+  double tolerance
+);
+
+
+// Whether object b is a copy of object a: every facet of a, moved by
+// x' = rotation x + translation, lands on a facet of b within tolerance.
+// The principal frames are tried first, in each direction, then translation
+// alone for parts whose axes are ambiguous, such as cubes.
+bool
+Match(
+  const STLFacet* facets,
+  const uint32_t* a,
+  const PoseT& poseA,
+  const uint32_t* b,
+  const PoseT& poseB,
+  double tolerance,
+  double (&rotation)[3][3],
+  double (&translation)[3]
+);
+
+
+} /* namespace PoseSTL */
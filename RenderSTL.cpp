@@ -0,0 +1,497 @@
+#include "RenderSTL.hpp"
+
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <algorithm>
+
+#include "STLBIfc.hpp"
+#include "ParallelSTL.hpp"
+
+#define RENDER_TILE_SIZE  32
+#define RENDER_BACKGROUND 255
+
+namespace RenderSTL {
+
+
+// A facet in screen space: pixels across and down, depth away from the
+// camera, and its grey level.
+typedef struct
+Screen {
+  float     m_X[3];
+  float     m_Y[3];
+  float     m_Z[3];
+  uint8_t   m_Shade;
+} ScreenT;
+
+
+using Vector = std::array<double, 3>;
+
+
+static Vector
+Normalize(
+  const Vector& v
+) {
+  double length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  return { v[0] / length, v[1] / length, v[2] / length };
+}
+
+
+static Vector
+Cross(
+  const Vector& a,
+  const Vector& b
+) {
+  return { a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+}
+
+
+static double
+Dot(
+  const Vector& a,
+  const float* b
+) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+
+// Pixels of a tile whose centre the facet covers, keeping the nearest, with the
+// top-left rule deciding centres on an edge.
+static void
+Rasterize(
+  const ScreenT& s,
+  int x0,
+  int y0,
+  int x1,
+  int y1,
+  uint32_t width,
+  std::vector<float>& depth,
+  std::vector<uint8_t>& shade
+) {
+  float area = (s.m_X[1] - s.m_X[0]) * (s.m_Y[2] - s.m_Y[0]) -
+               (s.m_Y[1] - s.m_Y[0]) * (s.m_X[2] - s.m_X[0]);
+  if (area == 0) {
+    return;
+  }
+
+  // Screen Y runs down, so counter-clockwise on screen is negative area.
+  int a = 0, b = 1, c = 2;
+  if (area > 0) {
+    std::swap(b, c);
+    area = -area;
+  }
+  const int v[3] = { a, b, c };
+
+  float dx[3], dy[3];
+  bool topLeft[3];
+  for (int e = 0; e < 3; e++) {
+    int p = v[e], q = v[(e + 1) % 3];
+    dx[e] = s.m_X[q] - s.m_X[p];
+    dy[e] = s.m_Y[q] - s.m_Y[p];
+    topLeft[e] = dy[e] > 0 || (dy[e] == 0 && dx[e] < 0);
+  }
+
+  float xMin = std::min({ s.m_X[0], s.m_X[1], s.m_X[2] });
+  float xMax = std::max({ s.m_X[0], s.m_X[1], s.m_X[2] });
+  float yMin = std::min({ s.m_Y[0], s.m_Y[1], s.m_Y[2] });
+  float yMax = std::max({ s.m_Y[0], s.m_Y[1], s.m_Y[2] });
+  int i0 = std::max(x0, int(std::ceil(xMin - 0.5f)));
+  int i1 = std::min(x1 - 1, int(std::floor(xMax - 0.5f)));
+  int j0 = std::max(y0, int(std::ceil(yMin - 0.5f)));
+  int j1 = std::min(y1 - 1, int(std::floor(yMax - 0.5f)));
+
+  for (int j = j0; j <= j1; j++) {
+    float py = j + 0.5f;
+    for (int i = i0; i <= i1; i++) {
+      float px = i + 0.5f;
+
+      float w[3];
+      bool inside = true;
+      for (int e = 0; e < 3 && inside; e++) {
+        int p = v[e];
+        w[e] = dx[e] * (py - s.m_Y[p]) - dy[e] * (px - s.m_X[p]);
+        inside = w[e] < 0 || (w[e] == 0 && topLeft[e]);
+      }
+      if (!inside) {
+        continue;
+      }
+
+      // w[e] is opposite vertex v[(e + 2) % 3].
+      float z = (w[1] * s.m_Z[v[0]] + w[2] * s.m_Z[v[1]] + w[0] * s.m_Z[v[2]]) / area;
+      size_t pixel = size_t(j - y0) * width + (i - x0);
+      if (z < depth[pixel]) {
+        depth[pixel] = z;
+        shade[pixel] = s.m_Shade;
+      }
+    }
+  }
+}
+
+
+void
+Render(
+  const STLFacet* facets,
+  size_t count,
+  const float (&x)[2],
+  const float (&y)[2],
+  const float (&z)[2],
+  int threads,
+  ImageT& image
+) {
+  const uint32_t width = image.m_Width, height = image.m_Height;
+  image.m_RGB.assign(size_t(width) * height * 3, RENDER_BACKGROUND);
+  if (count == 0 || width == 0 || height == 0) {
+    return;
+  }
+
+  // Camera over the front right corner, looking at the centre of bounds.
+  Vector forward = Normalize({ -1.0, 1.0, -0.8 });
+  Vector right = Normalize(Cross(forward, { 0, 0, 1 }));
+  Vector up = Cross(right, forward);
+  Vector light = Normalize({ -0.4, 0.2, -1.0 });
+
+  float centre[3] = { (x[0] + x[1]) / 2, (y[0] + y[1]) / 2, (z[0] + z[1]) / 2 };
+  double radius = 0.5 * std::sqrt((x[1] - x[0]) * (x[1] - x[0]) +
+                                  (y[1] - y[0]) * (y[1] - y[0]) +
+                                  (z[1] - z[0]) * (z[1] - z[0]));
+  double scale = radius > 0 ? 0.95 * std::min(width, height) / (2 * radius) : 1;
+  double cx = Dot(right, centre), cy = Dot(up, centre), cz = Dot(forward, centre);
+
+  std::vector<ScreenT> screen(count);
+  ParallelSTL::For(threads, count, [&](size_t begin, size_t end, int) {
+    for (size_t f = begin; f < end; f++) {
+      const float* v[3] = { facets[f].m_Vertex1, facets[f].m_Vertex2, facets[f].m_Vertex3 };
+      auto& s = screen[f];
+      for (int n = 0; n < 3; n++) {
+        s.m_X[n] = width / 2.0 + (Dot(right, v[n]) - cx) * scale;
+        s.m_Y[n] = height / 2.0 - (Dot(up, v[n]) - cy) * scale;
+        s.m_Z[n] = Dot(forward, v[n]) - cz;
+      }
+
+      // Lit from either side, since facet winding is not trusted.
+      Vector e1 = { double(v[1][0]) - v[0][0], double(v[1][1]) - v[0][1], double(v[1][2]) - v[0][2] };
+      Vector e2 = { double(v[2][0]) - v[0][0], double(v[2][1]) - v[0][1], double(v[2][2]) - v[0][2] };
+      Vector n = Cross(e1, e2);
+      double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      double diffuse = length > 0 ?
+        std::fabs(n[0] * light[0] + n[1] * light[1] + n[2] * light[2]) / length : 0;
+      s.m_Shade = uint8_t(std::lround(40 + 200 * diffuse));
+    }
+  });
+
+  // Bin facets by tile: count per worker, then scatter at prefix offsets,
+  // which keeps each tile's facets in facet order.
+  const uint32_t tilesX = (width + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+  const uint32_t tilesY = (height + RENDER_TILE_SIZE - 1) / RENDER_TILE_SIZE;
+  const size_t nTiles = size_t(tilesX) * tilesY;
+
+  auto tiles = [&](const ScreenT& s, int (&t)[4]) {
+    float xMin = std::min({ s.m_X[0], s.m_X[1], s.m_X[2] });
+    float xMax = std::max({ s.m_X[0], s.m_X[1], s.m_X[2] });
+    float yMin = std::min({ s.m_Y[0], s.m_Y[1], s.m_Y[2] });
+    float yMax = std::max({ s.m_Y[0], s.m_Y[1], s.m_Y[2] });
+    if (!(xMax >= 0 && yMax >= 0 && xMin < width && yMin < height)) {
+      return false;
+    }
+    t[0] = std::max(0, int(xMin)) / RENDER_TILE_SIZE;
+    t[1] = std::min(int(width) - 1, int(xMax)) / RENDER_TILE_SIZE;
+    t[2] = std::max(0, int(yMin)) / RENDER_TILE_SIZE;
+    t[3] = std::min(int(height) - 1, int(yMax)) / RENDER_TILE_SIZE;
+    return true;
+  };
+
+  int nWorkers = ParallelSTL::Workers(threads, count);
+  std::vector<size_t> counts(size_t(nWorkers) * nTiles, 0);
+  ParallelSTL::For(threads, count, [&](size_t begin, size_t end, int thread) {
+    size_t* mine = &counts[size_t(thread) * nTiles];
+    for (size_t f = begin; f < end; f++) {
+      int t[4];
+      if (tiles(screen[f], t)) {
+        for (int ty = t[2]; ty <= t[3]; ty++) {
+          for (int tx = t[0]; tx <= t[1]; tx++) {
+            mine[size_t(ty) * tilesX + tx]++;
+          }
+        }
+      }
+    }
+  });
+
+  std::vector<size_t> first(nTiles + 1, 0);
+  std::vector<size_t> offsets(counts.size());
+  size_t total = 0;
+  for (size_t b = 0; b < nTiles; b++) {
+    first[b] = total;
+    for (int t = 0; t < nWorkers; t++) {
+      offsets[size_t(t) * nTiles + b] = total;
+      total += counts[size_t(t) * nTiles + b];
+    }
+  }
+  first[nTiles] = total;
+
+  std::vector<uint32_t> members(total);
+  ParallelSTL::For(threads, count, [&](size_t begin, size_t end, int thread) {
+    size_t* next = &offsets[size_t(thread) * nTiles];
+    for (size_t f = begin; f < end; f++) {
+      int t[4];
+      if (tiles(screen[f], t)) {
+        for (int ty = t[2]; ty <= t[3]; ty++) {
+          for (int tx = t[0]; tx <= t[1]; tx++) {
+            members[next[size_t(ty) * tilesX + tx]++] = f;
+          }
+        }
+      }
+    }
+  });
+
+  ParallelSTL::For(threads, nTiles, [&](size_t begin, size_t end, int) {
+    std::vector<float> depth;
+    std::vector<uint8_t> shade;
+
+    for (size_t b = begin; b < end; b++) {
+      int x0 = (b % tilesX) * RENDER_TILE_SIZE;
+      int y0 = (b / tilesX) * RENDER_TILE_SIZE;
+      int x1 = std::min<int>(width, x0 + RENDER_TILE_SIZE);
+      int y1 = std::min<int>(height, y0 + RENDER_TILE_SIZE);
+      uint32_t w = x1 - x0;
+
+      depth.assign(size_t(w) * (y1 - y0), HUGE_VALF);
+      shade.assign(depth.size(), RENDER_BACKGROUND);
+      for (size_t m = first[b]; m < first[b + 1]; m++) {
+        Rasterize(screen[members[m]], x0, y0, x1, y1, w, depth, shade);
+      }
+
+      for (int j = y0; j < y1; j++) {
+        for (int i = x0; i < x1; i++) {
+          uint8_t g = shade[size_t(j - y0) * w + (i - x0)];
+          uint8_t* rgb = &image.m_RGB[(size_t(j) * width + i) * 3];
+          // A cool tint on the part keeps it apart from the white background.
+          rgb[0] = g == RENDER_BACKGROUND ? g : uint8_t(g * 0.85);
+          rgb[1] = g == RENDER_BACKGROUND ? g : uint8_t(g * 0.92);
+          rgb[2] = g;
+        }
+      }
+    }
+  }, 1);
+}
+
+
+static uint32_t
+Crc32(
+  const uint8_t* data,
+  size_t length,
+  uint32_t crc = 0
+) {
+  static uint32_t table[256] = {};
+  static bool ready = [] {
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; k++) {
+        c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      }
+      table[n] = c;
+    }
+    return true;
+  }();
+  (void) ready;
+
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+
+// Least significant bit first, as deflate packs its stream.
+class
+Bits {
+  public:
+    void
+    Put(
+      uint32_t value,
+      int count
+    ) {
+      m_Buffer |= uint64_t(value) << m_Count;
+      m_Count += count;
+      while (m_Count >= 8) {
+        m_Bytes.push_back(uint8_t(m_Buffer));
+        m_Buffer >>= 8;
+        m_Count -= 8;
+      }
+    }
+
+    // Huffman codes go most significant bit first.
+    void
+    Code(
+      uint32_t code,
+      int count
+    ) {
+      uint32_t reversed = 0;
+      for (int k = 0; k < count; k++) {
+        reversed |= ((code >> k) & 1) << (count - 1 - k);
+      }
+      Put(reversed, count);
+    }
+
+    std::vector<uint8_t>&
+    Flush() {
+      if (m_Count > 0) {
+        m_Bytes.push_back(uint8_t(m_Buffer));
+        m_Buffer = 0;
+        m_Count = 0;
+      }
+      return m_Bytes;
+    }
+
+  private:
+    uint64_t              m_Buffer = 0;
+    int                   m_Count = 0;
+    std::vector<uint8_t>  m_Bytes;
+};
+
+
+static void
+Literal(
+  Bits& bits,
+  uint32_t symbol
+) {
+  if (symbol < 144) {
+    bits.Code(0x30 + symbol, 8);
+  } else if (symbol < 256) {
+    bits.Code(0x190 + symbol - 144, 9);
+  } else if (symbol < 280) {
+    bits.Code(symbol - 256, 7);
+  } else {
+    bits.Code(0xc0 + symbol - 280, 8);
+  }
+}
+
+
+// zlib stream of one fixed Huffman block.  Rows are Sub filtered, so flat
+// shading turns into runs of zeros, and runs are coded as distance 1
+// matches; that is most of what a thumbnail compresses by.
+static std::vector<uint8_t>
+Deflate(
+  const std::vector<uint8_t>& data
+) {
+  static const uint16_t base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+  };
+  static const uint8_t extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+  };
+
+  Bits bits;
+  bits.Put(0x78, 8);
+  bits.Put(0x01, 8);
+  bits.Put(1, 1);     // Final block.
+  bits.Put(1, 2);     // Fixed Huffman codes.
+
+  for (size_t i = 0; i < data.size();) {
+    size_t run = 0;
+    if (i > 0) {
+      while (run < 258 && i + run < data.size() && data[i + run] == data[i - 1]) {
+        run++;
+      }
+    }
+
+    if (run < 3) {
+      Literal(bits, data[i]);
+      i++;
+      continue;
+    }
+
+    int code = 28;
+    while (base[code] > run) {
+      code--;
+    }
+    Literal(bits, 257 + code);
+    bits.Put(run - base[code], extra[code]);
+    bits.Code(0, 5);    // Distance 1.
+    i += run;
+  }
+  Literal(bits, 256);
+
+  auto& bytes = bits.Flush();
+
+  uint32_t a = 1, b = 0;
+  for (auto byte : data) {
+    a = (a + byte) % 65521;
+    b = (b + a) % 65521;
+  }
+  uint32_t adler = (b << 16) | a;
+  for (int k = 3; k >= 0; k--) {
+    bytes.push_back(uint8_t(adler >> (8 * k)));
+  }
+  return bytes;
+}
+
+
+static void
+Chunk(
+  std::ofstream& output,
+  const char* type,
+  const std::vector<uint8_t>& data
+) {
+  uint8_t length[4] = {
+    uint8_t(data.size() >> 24), uint8_t(data.size() >> 16),
+    uint8_t(data.size() >> 8), uint8_t(data.size())
+  };
+  output.write(reinterpret_cast<const char*>(length), 4);
+  output.write(type, 4);
+  output.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+  uint32_t crc = Crc32(reinterpret_cast<const uint8_t*>(type), 4);
+  crc = Crc32(data.data(), data.size(), crc);
+  uint8_t trailer[4] = { uint8_t(crc >> 24), uint8_t(crc >> 16), uint8_t(crc >> 8), uint8_t(crc) };
+  output.write(reinterpret_cast<const char*>(trailer), 4);
+}
+
+
+bool
+Save(
+  const std::string& filename,
+  const ImageT& image
+) {
+  std::ofstream output{filename, std::ios::binary | std::ios::out};
+  bool png = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".png") == 0;
+
+  if (!png) {
+    output << "P6\n" << image.m_Width << " " << image.m_Height << "\n255\n";
+    output.write(reinterpret_cast<const char*>(image.m_RGB.data()), image.m_RGB.size());
+    output.close();
+    return bool(output);
+  }
+
+  const size_t stride = size_t(image.m_Width) * 3;
+  std::vector<uint8_t> rows;
+  rows.reserve((stride + 1) * image.m_Height);
+  for (size_t j = 0; j < image.m_Height; j++) {
+    const uint8_t* row = &image.m_RGB[j * stride];
+    rows.push_back(1);    // Sub filter.
+    for (size_t i = 0; i < stride; i++) {
+      rows.push_back(uint8_t(row[i] - (i >= 3 ? row[i - 3] : 0)));
+    }
+  }
+
+  std::vector<uint8_t> header = {
+    uint8_t(image.m_Width >> 24), uint8_t(image.m_Width >> 16),
+    uint8_t(image.m_Width >> 8), uint8_t(image.m_Width),
+    uint8_t(image.m_Height >> 24), uint8_t(image.m_Height >> 16),
+    uint8_t(image.m_Height >> 8), uint8_t(image.m_Height),
+    8, 2, 0, 0, 0     // 8 bit RGB, no interlace.
+  };
+
+  static const char signature[8] = { '\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n' };
+  output.write(signature, 8);
+  Chunk(output, "IHDR", header);
+  Chunk(output, "IDAT", Deflate(rows));
+  Chunk(output, "IEND", {});
+  output.close();
+  return bool(output);
+}
+
+
+} /* namespace RenderSTL */
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct STLFacet;
+
+namespace RenderSTL {
+
+
+typedef struct
+Image {
+  uint32_t              m_Width;
+  uint32_t              m_Height;
+  std::vector<uint8_t>  m_RGB;    // Row major, top row first.
+} ImageT;
+
+
+// Flat shaded orthographic view from above the front right corner, framed
+// so the bounding sphere of bounds fills the image.  The image is cut into
+// tiles, facets are binned by the tiles their screen box touches, and each
+// tile is rasterized with its own depth buffer by one thread.  Where depths
+// tie the earlier facet wins, so the image does not depend on threads.
+void
+Render(
+  const STLFacet* facets,
+  size_t count,
+  const float (&x)[2],
+  const float (&y)[2],
+  const float (&z)[2],
+  int threads,
+  ImageT& image
+);
+
+
+// Write image as binary PPM, or as PNG if filename ends in .png.
+bool
+Save(
+  const std::string& filename,
+  const ImageT& image
+);
+
+
+} /* namespace RenderSTL */
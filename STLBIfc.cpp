@@ -3,10 +3,29 @@
 #include <sstream>
 #include <fstream>
 #include <cstring>
+#include <cerrno>
 #include <cmath>
+#include <tuple>
+#include <numeric>
 #include <functional>
+#include <atomic>
+#include <algorithm>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "STLBIfc.hpp"
+#include "BVHSTL.hpp"
+#include "BufferSTL.hpp"
+#include "CacheSTL.hpp"
+#include "CutSTL.hpp"
+#include "DiffSTL.hpp"
+#include "FormatSTL.hpp"
+#include "HullSTL.hpp"
+#include "OrientSTL.hpp"
+#include "ParallelSTL.hpp"
+#include "PoseSTL.hpp"
 
 #define STLB_BLOCK_SIZE 4096
 
@@ -19,67 +38,50 @@
 #pragma pack(pop)
 
 
-// Apply rotation about X axis
-//    [ 1     0      0   ]  [x]
-//    [ 0     cos@  -sin@]  [y]
-//    [ 0     sin@   cos@]  [z]
-static inline void
-RotateX(
-  const float &angle,
-  float (&xyz)[3]
+// Rotation about X, then Y, then Z, as one matrix M = Rz.Ry.Rx, so the
+// sines and cosines are taken once per call rather than once per vertex.
+//    Rx: [ 1     0      0   ]  Ry: [ cos@  0     sin@]  Rz: [ cos@ -sin@  0   ]
+//        [ 0     cos@  -sin@]      [ 0     1     0   ]      [ sin@  cos@  0   ]
+//        [ 0     sin@   cos@]      [-sin@  0     cos@]      [ 0     0     1   ]
+static void
+Rotation(
+  float x,
+  float y,
+  float z,
+  float (&m)[3][3]
 ) {
-  float yN = ( std::cos(angle) * xyz[1]) +
-             (-std::sin(angle) * xyz[2]);
-  float zN = ( std::sin(angle) * xyz[1]) +
-             ( std::cos(angle) * xyz[2]);
-  xyz[1] = yN;
-  xyz[2] = zN;
-}
-
+  double cx = std::cos(x), sx = std::sin(x);
+  double cy = std::cos(y), sy = std::sin(y);
+  double cz = std::cos(z), sz = std::sin(z);
 
-// Apply rotation about Y axis
-//    [ cos@  0     sin@]
-//    [ 0     1     0   ]
-//    [-sin@  0     cos@]
-static inline void
-RotateY(
-  const float &angle,
-  float (&xyz)[3]
-) {
-  float xN = ( std::cos(angle) * xyz[0]) +
-             ( std::sin(angle) * xyz[2]);
-  float zN = (-std::sin(angle) * xyz[0]) +
-             ( std::cos(angle) * xyz[2]);
-  xyz[0] = xN;
-  xyz[2] = zN;
+  m[0][0] = cz * cy;  m[0][1] = cz * sy * sx - sz * cx;  m[0][2] = cz * sy * cx + sz * sx;
+  m[1][0] = sz * cy;  m[1][1] = sz * sy * sx + cz * cx;  m[1][2] = sz * sy * cx - cz * sx;
+  m[2][0] = -sy;      m[2][1] = cy * sx;                 m[2][2] = cy * cx;
 }
 
 
-// Apply rotation about Z axis
-//    [ cos@ -sin@  0   ]
-//    [ sin@  cos@  0   ]
-//    [ 0     0     1   ]
 static inline void
-RotateZ(
-  const float &angle,
+Apply(
+  const float (&m)[3][3],
   float (&xyz)[3]
 ) {
-  float xN = ( std::cos(angle) * xyz[0]) +
-             (-std::sin(angle) * xyz[1]);
-  float yN = ( std::sin(angle) * xyz[0]) +
-             ( std::cos(angle) * xyz[1]);
+  float xN = m[0][0] * xyz[0] + m[0][1] * xyz[1] + m[0][2] * xyz[2];
+  float yN = m[1][0] * xyz[0] + m[1][1] * xyz[1] + m[1][2] * xyz[2];
+  float zN = m[2][0] * xyz[0] + m[2][1] * xyz[1] + m[2][2] * xyz[2];
   xyz[0] = xN;
   xyz[1] = yN;
+  xyz[2] = zN;
 }
 
 
 class STLBObj::Impl {
     public:
         Impl(int threads) : m_Threads(threads) {
-            buffer.reserve(STLB_BLOCK_SIZE);
+            buffer.Reserve(STLB_BLOCK_SIZE);
             const char * IDENT = "STLB Reader/Writer";
-            buffer.resize(sizeof(STLHeaderT));
-            std::strcpy(const_cast<char*>(&buffer[0]), IDENT);
+            buffer.Resize(sizeof(STLHeaderT));
+            std::memset(&buffer[0], 0, sizeof(STLHeaderT));
+            std::strcpy(&buffer[0], IDENT);
         }
 
 
@@ -90,23 +92,65 @@ class STLBObj::Impl {
             std::ifstream input{filename};
 
             input.seekg(0, input.end);
-            size_t length = input.tellg();
+            std::streamoff length = input.tellg();
             input.seekg(0, input.beg);
 
-            if (length > 0 && length > sizeof(STLHeaderT)) {
-                buffer.resize(length);
-                input.read(&buffer[0], length);
+            // A short or unreadable file leaves the buffer empty, which
+            // Valid() rejects; callers check Valid() and report it.
+            if (input && length >= std::streamoff(sizeof(STLHeaderT))) {
+                buffer.Resize(length);
+                if (!input.read(&buffer[0], length)) {
+                    buffer.Resize(0);
+                }
             }
 
             input.close();
+        }
 
-            auto f = GetNFacets();
 
-            if (buffer.size() != (f * sizeof(STLFacetT) + sizeof(STLHeaderT))) {
-                std::cerr << "Invalid or Corrupt STLB. " << buffer.size() << " != "
-                          << (f * sizeof(STLFacetT) + sizeof(STLHeaderT)) << std::endl;
+        // Copies an STLB image already in memory; check Valid() after.
+        Impl(
+            const void *data,
+            size_t length,
+            int threads
+        ) : m_Threads(threads) {
+            if (length < sizeof(STLHeaderT)) {
                 return;
             }
+
+            buffer.Resize(length);
+            std::memcpy(&buffer[0], data, length);
+        }
+
+
+        Impl(const Impl &other) = default;
+
+
+        size_t
+        Bytes() {
+            return buffer.Size();
+        }
+
+
+        bool
+        Valid() {
+            return buffer.Size() >= sizeof(STLHeaderT) &&
+                   buffer.Size() == (GetNFacets() * sizeof(STLFacetT) + sizeof(STLHeaderT));
+        }
+
+
+        const char *
+        Data() {
+            return buffer.Data();
+        }
+
+
+        const STLFacetT *
+        Facets(
+            size_t &count
+        ) {
+            count = GetNFacets();
+            return GetFacets();
         }
 
 
@@ -116,41 +160,24 @@ class STLBObj::Impl {
         ) {
             STLHeaderT * h = GetHeader();
 
-            out << "\tHeader:  " << h->m_Header << std::endl;
-            out << "\tFacets:  " << h->m_Facets << std::endl;
-
-            STLFacetT * facets = GetFacets();
-            auto nFacets = GetNFacets();
-            for (int i = 0; i < nFacets; i++) {
-                out << "Facet: " << i << std::endl;
+            out << "\tHeader:  " << std::string(h->m_Header, strnlen(h->m_Header, sizeof(h->m_Header))) << "\n";
+            out << "\tFacets:  " << h->m_Facets << "\n";
 
-                if (facets[i].m_Attr != 0) {
-                    out << "Invalid or Corrupt STLB." << std::endl;
-                    return false;
-                }
-
-                out << "\tNormal: "
-                    << facets[i].m_Normal[0] << ", "
-                    << facets[i].m_Normal[1] << ", "
-                    << facets[i].m_Normal[2] << std::endl;
-
-                out << "\tVertex1: "
-                    << facets[i].m_Vertex1[0] << ", "
-                    << facets[i].m_Vertex1[1] << ", "
-                    << facets[i].m_Vertex1[2] << std::endl;
+            return FormatSTL::Dump(out, GetFacets(), GetNFacets(), m_Threads);
+        }
 
-                out << "\tVertex2: "
-                    << facets[i].m_Vertex2[0] << ", "
-                    << facets[i].m_Vertex2[1] << ", "
-                    << facets[i].m_Vertex2[2] << std::endl;
 
-                out << "\tVertex3: "
-                    << facets[i].m_Vertex3[0] << ", "
-                    << facets[i].m_Vertex3[1] << ", "
-                    << facets[i].m_Vertex3[2] << std::endl;
-            }
+        bool
+        SaveAscii(
+            const std::string &filename
+        ) {
+            auto name = filename.substr(filename.find_last_of('/') + 1);
+            name = name.substr(0, name.rfind('.'));
 
-            return true;
+            std::ofstream output{filename, std::ios::binary | std::ios::out};
+            bool written = FormatSTL::Ascii(output, name, GetFacets(), GetNFacets(), m_Threads);
+            output.close();
+            return written && bool(output);
         }
 
 
@@ -159,9 +186,9 @@ class STLBObj::Impl {
             const std::string &filename
         ) {
             std::ofstream output{filename, std::ios::binary | std::ios::out};
-            output.write(reinterpret_cast<char*>(&buffer[0]), buffer.size());
+            output.write(buffer.Data(), buffer.Size());
             output.close();
-            return true;
+            return bool(output);
         }
 
 
@@ -314,6 +341,7 @@ class STLBObj::Impl {
             }
 
             header->m_Facets = index;
+            buffer.Resize(sizeof(STLHeaderT) + index * sizeof(STLFacetT));
 
             return true;
         }
@@ -323,21 +351,114 @@ class STLBObj::Impl {
         Add(
             const STLFacetT &facet
         ) {
-            auto header = GetHeader();
             auto facets = GetNFacets();
 
             auto offset = sizeof(STLHeaderT) + (facets * sizeof(STLFacetT));
 
-            if (buffer.size() < (offset + sizeof(STLFacet))) {
-                buffer.resize(buffer.size()*2);
+            // Grow by capacity, so the size always ends at the last facet.
+            // Growing moves the buffer, so the header is looked up after.
+            if (buffer.Capacity() < (offset + sizeof(STLFacetT))) {
+                buffer.Reserve(std::max(buffer.Capacity() * 2, offset + sizeof(STLFacetT)));
             }
+            buffer.Resize(offset + sizeof(STLFacetT));
 
             std::memcpy(reinterpret_cast<char *>(&buffer[offset]),
                         reinterpret_cast<const char *>(&facet),
                         sizeof(STLFacetT));
 
-            header->m_Facets++;
+            GetHeader()->m_Facets++;
+
+            return true;
+        }
+
+
+        // Replicate the facets count[0] x count[1] x count[2] times, each copy
+        // offset by the bounding box extent plus spacing along every axis.
+        // Writes straight to filename when one is given, otherwise replaces
+        // the facet buffer.
+        bool
+        Array(
+            const unsigned (&count)[3],
+            const float (&spacing)[3],
+            const std::string *filename
+        ) {
+            STLFacetT * facets = GetFacets();
+            size_t nFacets = GetNFacets();
+
+            float bounds[3][2] = {};
+            MinMax(bounds[0], bounds[1], bounds[2]);
+
+            float pitch[3];
+            for (int k = 0; k < 3; k++) {
+                pitch[k] = (bounds[k][1] - bounds[k][0]) + spacing[k];
+            }
+
+            size_t tiles = size_t(count[0]) * count[1] * count[2];
+            size_t total = tiles * nFacets;
+            if (total > UINT32_MAX) {
+                std::cerr << "Array ERROR: " << total << " facets exceeds the STLB limit." << std::endl;
+                return false;
+            }
+
+            STLHeaderT header = *GetHeader();
+            header.m_Facets = total;
+
+            auto tile = [&](size_t t, STLFacetT * dst) {
+                float offset[3] = {
+                    pitch[0] * (t % count[0]),
+                    pitch[1] * ((t / count[0]) % count[1]),
+                    pitch[2] * (t / (size_t(count[0]) * count[1]))
+                };
+
+                for (size_t i = 0; i < nFacets; i++) {
+                    dst[i] = facets[i];
+                    for (int k = 0; k < 3; k++) {
+                        dst[i].m_Vertex1[k] += offset[k];
+                        dst[i].m_Vertex2[k] += offset[k];
+                        dst[i].m_Vertex3[k] += offset[k];
+                    }
+                }
+            };
+
+            if (filename) {
+                int fd = open(filename->c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                if (fd < 0) {
+                    std::cerr << "Array ERROR: " << *filename << ": " << std::strerror(errno) << std::endl;
+                    return false;
+                }
+
+                std::atomic<bool> ok{
+                    pwrite(fd, &header, sizeof(STLHeaderT), 0) == sizeof(STLHeaderT)
+                };
+
+                ParallelSTL::For(m_Threads, tiles, [&](size_t begin, size_t end, int) {
+                    std::vector<STLFacetT> local(nFacets);
+                    size_t bytes = nFacets * sizeof(STLFacetT);
+                    for (size_t t = begin; t < end && ok; t++) {
+                        tile(t, local.data());
+                        off_t offset = sizeof(STLHeaderT) + t * bytes;
+                        if (pwrite(fd, local.data(), bytes, offset) != ssize_t(bytes)) {
+                            ok = false;
+                        }
+                    }
+                }, 1);
+
+                close(fd);
+                return ok;
+            }
+
+            BufferSTL::Buffer output;
+            output.Resize(sizeof(STLHeaderT) + total * sizeof(STLFacetT));
+            std::memcpy(&output[0], &header, sizeof(STLHeaderT));
+            STLFacetT * dst = reinterpret_cast<STLFacetT *>(&output[sizeof(STLHeaderT)]);
+
+            ParallelSTL::For(m_Threads, tiles, [&](size_t begin, size_t end, int) {
+                for (size_t t = begin; t < end; t++) {
+                    tile(t, dst + t * nFacets);
+                }
+            }, 1);
 
+            buffer.Swap(output);
             return true;
         }
 
@@ -348,40 +469,553 @@ class STLBObj::Impl {
             float y,
             float z
         ) {
+            if (x == 0.0 && y == 0.0 && z == 0.0) {
+                return;
+            }
+
+            float m[3][3];
+            Rotation(x, y, z, m);
+
             STLFacetT * facets = GetFacets();
-            int nFacets = GetNFacets();
-            for (int i = 0; i < nFacets; i++) {
-                if (x != 0.0) {
-                  RotateX(x, facets[i].m_Normal);
-                  RotateX(x, facets[i].m_Vertex1);
-                  RotateX(x, facets[i].m_Vertex2);
-                  RotateX(x, facets[i].m_Vertex3);
+            size_t nFacets = GetNFacets();
+            ParallelSTL::For(m_Threads, nFacets, [&](size_t begin, size_t end, int) {
+                for (size_t i = begin; i < end; i++) {
+                    Apply(m, facets[i].m_Normal);
+                    Apply(m, facets[i].m_Vertex1);
+                    Apply(m, facets[i].m_Vertex2);
+                    Apply(m, facets[i].m_Vertex3);
+                }
+            });
+        }
+
+
+        OrientSTL::OrientationT
+        OptimizeOrientation(
+            size_t candidates
+        ) {
+            STLFacetT * facets = GetFacets();
+            size_t nFacets = GetNFacets();
+
+            std::vector<HullSTL::Point> points(3 * nFacets);
+            ParallelSTL::For(m_Threads, nFacets, [&](size_t begin, size_t end, int) {
+                for (size_t i = begin; i < end; i++) {
+                    Corners(facets[i], &points[3 * i]);
+                }
+            });
+
+            auto best = OrientSTL::Optimize(points, candidates, m_Threads);
+            Rotate(best.m_Angle[0], best.m_Angle[1], 0);
+            return best;
+        }
+
+
+        // Permute facets along a space filling curve, out of place so each
+        // worker copies a contiguous range of the new order.
+        void
+        Reorder(
+            CurveSTL::Curve curve
+        ) {
+            size_t nFacets = GetNFacets();
+            if (nFacets < 2) {
+                return;
+            }
+
+            float x[2], y[2], z[2];
+            MinMax(x, y, z);
+
+            std::vector<uint32_t> order;
+            CurveSTL::Order(GetFacets(), nFacets, x, y, z, curve, m_Threads, order);
+
+            BufferSTL::Buffer output;
+            output.Resize(buffer.Size());
+            std::memcpy(&output[0], &buffer[0], sizeof(STLHeaderT));
+            const STLFacetT * src = GetFacets();
+            STLFacetT * dst = reinterpret_cast<STLFacetT *>(&output[sizeof(STLHeaderT)]);
+
+            ParallelSTL::For(m_Threads, nFacets, [&](size_t begin, size_t end, int) {
+                for (size_t i = begin; i < end; i++) {
+                    dst[i] = src[order[i]];
                 }
+            });
+
+            buffer.Swap(output);
+        }
 
-                if (y != 0.0) {
-                  RotateY(y, facets[i].m_Normal);
-                  RotateY(y, facets[i].m_Vertex1);
-                  RotateY(y, facets[i].m_Vertex2);
-                  RotateY(y, facets[i].m_Vertex3);
+
+        void
+        Split(
+          const std::string &directory
+        ) {
+          std::vector<uint32_t> labels;
+          std::vector<uint32_t> weld;
+          size_t nObjects = Topology(labels, weld);
+
+          STLFacetT * facets = GetFacets();
+
+          std::vector<uint32_t> first;
+          std::vector<uint32_t> members;
+          Members(labels, nObjects, first, members);
+
+          ParallelSTL::For(m_Threads, nObjects, [&](size_t begin, size_t end, int) {
+            std::vector<STLFacetT> object;
+            for (size_t n = begin; n < end; n++) {
+              object.clear();
+              for (auto i = first[n]; i < first[n + 1]; i++) {
+                object.push_back(facets[members[i]]);
+              }
+
+              std::stringstream outname;
+              outname << directory << "/manifold_object_" << n << ".stl";
+              Write(outname.str(), object);
+            }
+          }, 1);
+        }
+
+
+        long
+        Cut(
+          const float (&plane)[4],
+          const std::string &directory
+        ) {
+          std::vector<STLFacetT> upper, lower;
+          long loops = CutSTL::Cut(GetFacets(), GetNFacets(), plane, m_Threads, upper, lower);
+          if (loops < 0) {
+            return loops;
+          }
+
+          Write(directory + "/cut_upper.stl", upper);
+          Write(directory + "/cut_lower.stl", lower);
+          return loops;
+        }
+
+
+        uint64_t
+        Hash(
+          float quantum
+        ) {
+          return DiffSTL::Hash(GetFacets(), GetNFacets(), quantum, m_Threads);
+        }
+
+
+        void
+        Diff(
+          Impl &other,
+          float quantum,
+          std::vector<STLFacetT> &removed,
+          std::vector<STLFacetT> &added
+        ) {
+          std::vector<uint32_t> removedIDs, addedIDs;
+          DiffSTL::Diff(GetFacets(), GetNFacets(), other.GetFacets(), other.GetNFacets(),
+                        quantum, m_Threads, removedIDs, addedIDs);
+
+          removed.clear();
+          for (auto i : removedIDs) {
+            removed.push_back(GetFacets()[i]);
+          }
+          added.clear();
+          for (auto i : addedIDs) {
+            added.push_back(other.GetFacets()[i]);
+          }
+        }
+
+
+        // One tree over every facet; queries are taken in Morton order of
+        // the points, so neighbouring queries walk the same nodes.
+        bool
+        Query(
+          const float *points,
+          size_t count,
+          float *distances
+        ) {
+          STLFacetT * facets = GetFacets();
+          size_t nFacets = GetNFacets();
+          if (!nFacets) {
+            return false;
+          }
+
+          std::vector<BVHSTL::Triangle> triangles(nFacets);
+          std::vector<uint32_t> ids(nFacets);
+          ParallelSTL::For(m_Threads, nFacets, [&](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; i++) {
+              triangles[i] = ToTriangle(facets[i]);
+              ids[i] = i;
+            }
+          });
+          BVHSTL::Tree tree(std::move(triangles), std::move(ids));
+
+          const auto &bounds = tree.Bounds();
+          const float cells = float((1u << 21) - 1);
+          std::vector<uint64_t> keys(count);
+          ParallelSTL::For(m_Threads, count, [&](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; i++) {
+              uint32_t cell[3];
+              for (int k = 0; k < 3; k++) {
+                float extent = bounds.m_Max[k] - bounds.m_Min[k];
+                float t = extent > 0 ? (points[3 * i + k] - bounds.m_Min[k]) / extent : 0;
+                cell[k] = uint32_t(std::clamp(t * cells, 0.0f, cells));
+              }
+              keys[i] = CurveSTL::Morton(cell[0], cell[1], cell[2]);
+            }
+          });
+          std::vector<uint32_t> order;
+          CurveSTL::Sort(keys, m_Threads, order);
+
+          ParallelSTL::For(m_Threads, count, [&](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; i++) {
+              const float *point = &points[3 * size_t(order[i])];
+              const float p[3] = { point[0], point[1], point[2] };
+              float distance = std::sqrt(tree.Nearest(p));
+              distances[order[i]] = tree.Inside(p) ? -distance : distance;
+            }
+          }, 256);
+          return true;
+        }
+
+
+        // Split, writing each distinct part once, under the index of its
+        // first copy, and every object's transform from that part to
+        // manifold_instances.txt.  Objects are grouped by facet count, the
+        // groups matched in parallel; within a group the parts are bucketed
+        // by volume step, and each object is only matched against the parts
+        // in its own and the neighbouring steps.
+        size_t
+        SplitUnique(
+          float tolerance,
+          const std::string &directory
+        ) {
+          std::vector<uint32_t> labels;
+          std::vector<uint32_t> weld;
+          size_t nObjects = Topology(labels, weld);
+
+          STLFacetT * facets = GetFacets();
+
+          std::vector<uint32_t> first;
+          std::vector<uint32_t> members;
+          Members(labels, nObjects, first, members);
+
+          std::vector<PoseSTL::PoseT> poses(nObjects);
+          ParallelSTL::For(m_Threads, nObjects, [&](size_t begin, size_t end, int) {
+            for (size_t n = begin; n < end; n++) {
+              poses[n] = PoseSTL::Normalize(facets, &members[first[n]], first[n + 1] - first[n]);
+            }
+          }, 1);
+
+          std::vector<uint32_t> order(nObjects);
+          std::iota(order.begin(), order.end(), 0);
+          std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return poses[a].m_Facets < poses[b].m_Facets;
+          });
+
+          std::vector<size_t> groups;
+          for (size_t i = 0; i < nObjects; i++) {
+            if (!i || poses[order[i]].m_Facets != poses[order[i - 1]].m_Facets) {
+              groups.push_back(i);
+            }
+          }
+          groups.push_back(nObjects);
+
+          typedef struct
+          Instance {
+            size_t  m_Part;
+            double  m_Rotation[3][3];
+            double  m_Translation[3];
+          } InstanceT;
+
+          std::vector<InstanceT> instances(nObjects);
+          ParallelSTL::For(m_Threads, groups.size() - 1, [&](size_t begin, size_t end, int) {
+            for (size_t g = begin; g < end; g++) {
+              std::unordered_map<long, std::vector<uint32_t>> steps;
+              for (size_t i = groups[g]; i < groups[g + 1]; i++) {
+                uint32_t n = order[i];
+                auto &instance = instances[n];
+                instance.m_Part = n;
+
+                long step = PoseSTL::Step(poses[n], tolerance);
+                for (long s = step - 1; s <= step + 1 && instance.m_Part == n; s++) {
+                  auto found = steps.find(s);
+                  if (found == steps.end()) {
+                    continue;
+                  }
+                  for (auto m : found->second) {
+                    if (PoseSTL::Match(facets, &members[first[m]], poses[m], &members[first[n]],
+                                       poses[n], tolerance, instance.m_Rotation, instance.m_Translation)) {
+                      instance.m_Part = m;
+                      break;
+                    }
+                  }
                 }
 
-                if (z != 0.0) {
-                  RotateZ(z, facets[i].m_Normal);
-                  RotateZ(z, facets[i].m_Vertex1);
-                  RotateZ(z, facets[i].m_Vertex2);
-                  RotateZ(z, facets[i].m_Vertex3);
+                if (instance.m_Part == n) {
+                  steps[step].push_back(n);
+                  for (int r = 0; r < 3; r++) {
+                    for (int c = 0; c < 3; c++) {
+                      instance.m_Rotation[r][c] = r == c;
+                    }
+                    instance.m_Translation[r] = 0;
+                  }
                 }
+              }
+            }
+          }, 1);
+
+          std::vector<uint32_t> parts;
+          for (size_t n = 0; n < nObjects; n++) {
+            if (instances[n].m_Part == n) {
+              parts.push_back(n);
+            }
+          }
+
+          ParallelSTL::For(m_Threads, parts.size(), [&](size_t begin, size_t end, int) {
+            std::vector<STLFacetT> object;
+            for (size_t p = begin; p < end; p++) {
+              object.clear();
+              for (auto i = first[parts[p]]; i < first[parts[p] + 1]; i++) {
+                object.push_back(facets[members[i]]);
+              }
+
+              std::stringstream outname;
+              outname << directory << "/manifold_object_" << parts[p] << ".stl";
+              Write(outname.str(), object);
+            }
+          }, 1);
+
+          std::ofstream manifest{directory + "/manifold_instances.txt"};
+          manifest << "# object part r00 r01 r02 r10 r11 r12 r20 r21 r22 tx ty tz" << std::endl;
+          manifest.precision(9);
+          for (size_t n = 0; n < nObjects; n++) {
+            auto &instance = instances[n];
+            manifest << n << " manifold_object_" << instance.m_Part << ".stl";
+            for (auto &row : instance.m_Rotation) {
+              for (auto c : row) {
+                manifest << " " << c;
+              }
+            }
+            for (auto t : instance.m_Translation) {
+              manifest << " " << t;
+            }
+            manifest << std::endl;
+          }
+
+          return parts.size();
+        }
+
+
+        bool
+        Voxelize(
+          unsigned resolution,
+          VoxelSTL::GridT &grid
+        ) {
+          float x[2], y[2], z[2];
+          MinMax(x, y, z);
+          return VoxelSTL::Voxelize(GetFacets(), GetNFacets(), x, y, z,
+                                    resolution, m_Threads, grid);
+        }
+
+
+        void
+        Render(
+          RenderSTL::ImageT &image
+        ) {
+          float x[2], y[2], z[2];
+          MinMax(x, y, z);
+          RenderSTL::Render(GetFacets(), GetNFacets(), x, y, z, m_Threads, image);
+        }
+
+
+        bool
+        Hull(
+          float &volume
+        ) {
+          STLFacetT * facets = GetFacets();
+          size_t nFacets = GetNFacets();
+
+          std::vector<HullSTL::Point> points(3 * nFacets);
+          ParallelSTL::For(m_Threads, nFacets, [&](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; i++) {
+              Corners(facets[i], &points[3 * i]);
             }
+          });
+          Weld(points, m_Threads);
+
+          std::vector<STLFacetT> hull;
+          if (!HullFacets(points, m_Threads, hull, volume)) {
+            return false;
+          }
+
+          buffer.Resize(sizeof(STLHeaderT) + hull.size() * sizeof(STLFacetT));
+          std::memcpy(GetFacets(), hull.data(), hull.size() * sizeof(STLFacetT));
+          GetHeader()->m_Facets = hull.size();
+          return true;
         }
 
 
         void
-        Split() {
-          GraphSTL::ContextPtr context = GraphSTL::CreateContext();
+        Hulls(
+          std::vector<float> &volumes,
+          const std::string &directory
+        ) {
+          std::vector<uint32_t> labels;
+          std::vector<uint32_t> weld;
+          size_t nObjects = Topology(labels, weld);
+
+          STLFacetT * facets = GetFacets();
 
+          std::vector<uint32_t> first;
+          std::vector<uint32_t> members;
+          Members(labels, nObjects, first, members);
+
+          volumes.assign(nObjects, 0);
+
+          ParallelSTL::For(m_Threads, nObjects, [&](size_t begin, size_t end, int) {
+            std::vector<HullSTL::Point> points;
+            std::vector<STLFacetT> hull;
+            for (size_t n = begin; n < end; n++) {
+              points.resize(3 * size_t(first[n + 1] - first[n]));
+              for (auto i = first[n]; i < first[n + 1]; i++) {
+                Corners(facets[members[i]], &points[3 * size_t(i - first[n])]);
+              }
+
+              Weld(points, 1);
+
+              hull.clear();
+              HullFacets(points, 1, hull, volumes[n]);
+
+              std::stringstream outname;
+              outname << directory << "/manifold_hull_" << n << ".stl";
+              Write(outname.str(), hull);
+            }
+          }, 1);
+        }
+
+
+        void
+        Cache(
+          const std::string &directory
+        ) {
+          m_CacheDirectory = directory;
+        }
+
+
+        size_t
+        Intersections(
+          std::vector<STLIntersectionT> &intersections
+        ) {
+          STLFacetT * facets = GetFacets();
+
+          std::vector<uint32_t> labels;
+          std::vector<uint32_t> weld;
+          size_t nObjects = Topology(labels, weld);
+
+          std::vector<uint32_t> first;
+          std::vector<uint32_t> members;
+          Members(labels, nObjects, first, members);
+
+          std::vector<std::unique_ptr<BVHSTL::Tree>> trees(nObjects);
+          ParallelSTL::For(m_Threads, nObjects, [&](size_t begin, size_t end, int) {
+            for (size_t o = begin; o < end; o++) {
+              std::vector<BVHSTL::Triangle> triangles;
+              std::vector<uint32_t> ids(members.begin() + first[o], members.begin() + first[o + 1]);
+              triangles.reserve(ids.size());
+              for (auto i : ids) {
+                triangles.push_back(ToTriangle(facets[i]));
+              }
+              trees[o] = std::make_unique<BVHSTL::Tree>(std::move(triangles), std::move(ids));
+            }
+          }, 1);
+
+          // Sweep and prune object bounds along X for candidate pairs; every
+          // object is also checked against itself.
+          std::vector<uint32_t> order(nObjects);
+          std::iota(order.begin(), order.end(), 0);
+          std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return trees[a]->Bounds().m_Min[0] < trees[b]->Bounds().m_Min[0];
+          });
+
+          std::vector<std::pair<uint32_t, uint32_t>> candidates;
+          for (size_t i = 0; i < nObjects; i++) {
+            candidates.push_back({order[i], order[i]});
+            const auto& a = trees[order[i]]->Bounds();
+            for (size_t j = i + 1; j < nObjects; j++) {
+              const auto& b = trees[order[j]]->Bounds();
+              if (b.m_Min[0] > a.m_Max[0]) {
+                break;
+              }
+              if (BVHSTL::Overlap(a, b)) {
+                candidates.push_back({
+                  std::min(order[i], order[j]), std::max(order[i], order[j])
+                });
+              }
+            }
+          }
+
+          int workers = ParallelSTL::Workers(m_Threads, candidates.size(), 1);
+          std::vector<std::vector<STLIntersectionT>> found(workers);
+          std::atomic<size_t> next{0};
+
+          ParallelSTL::For(m_Threads, workers, [&](size_t begin, size_t end, int) {
+            for (size_t w = begin; w < end; w++) {
+              auto& hits = found[w];
+              for (size_t c = next++; c < candidates.size(); c = next++) {
+                auto [a, b] = candidates[c];
+                const auto& treeA = *trees[a];
+                const auto& treeB = *trees[b];
+
+                auto test = [&](uint32_t i, uint32_t j) {
+                  const auto& t = treeA.m_Triangles[i];
+                  const auto& u = treeB.m_Triangles[j];
+                  if (a == b && SharesVertex(weld, treeA.m_IDs[i], treeB.m_IDs[j])) {
+                    return;
+                  }
+                  if (BVHSTL::Intersect(t, u)) {
+                    hits.push_back({{a, b}, {treeA.m_IDs[i], treeB.m_IDs[j]}});
+                  }
+                };
+
+                if (a == b) {
+                  treeA.Overlaps(test);
+                } else {
+                  treeA.Overlaps(treeB, test);
+                }
+              }
+            }
+          }, 1);
+
+          intersections.clear();
+          for (const auto& hits : found) {
+            intersections.insert(intersections.end(), hits.begin(), hits.end());
+          }
+
+          std::sort(intersections.begin(), intersections.end(),
+            [](const STLIntersectionT &a, const STLIntersectionT &b) {
+              return std::tie(a.m_Object[0], a.m_Object[1], a.m_Facet[0], a.m_Facet[1]) <
+                     std::tie(b.m_Object[0], b.m_Object[1], b.m_Facet[0], b.m_Facet[1]);
+            });
+
+          return intersections.size();
+        }
+
+    private:
+
+        // Manifold object labels and vertex weld ids for every facet, reused
+        // from the cache directory when the facet buffer is unchanged.
+        size_t
+        Topology(
+          std::vector<uint32_t> &labels,
+          std::vector<uint32_t> &weld
+        ) {
           STLFacetT * facets = GetFacets();
           int nFacets = GetNFacets();
 
+          uint64_t hash = 0;
+          if (!m_CacheDirectory.empty()) {
+            hash = CacheSTL::Hash(facets, nFacets * sizeof(STLFacetT), m_Threads);
+            if (CacheSTL::Load(m_CacheDirectory, hash, nFacets, labels, weld)) {
+              return labels.empty() ? 0 : *std::max_element(labels.begin(), labels.end()) + 1;
+            }
+          }
+
+          GraphSTL::ContextPtr context = GraphSTL::CreateContext();
+
           for (int i = 0; i < nFacets; i++) {
             GraphSTL::AddTriangle(
               context,
@@ -392,48 +1026,203 @@ class STLBObj::Impl {
             );
           }
 
-          std::list<GraphSTL::TrianglePtrList> manifold_objects;
-          GraphSTL::ManifoldObjects(context, manifold_objects);
+          size_t nObjects = GraphSTL::ManifoldLabels(context, labels, weld);
+
+          if (!m_CacheDirectory.empty()) {
+            CacheSTL::Store(m_CacheDirectory, hash, labels, weld);
+          }
+
+          return nObjects;
+        }
+
 
-          STLHeaderT objHeader;
-          STLFacetT  objFacet;
+        // Bucket facet indices by object; object n owns
+        // members[first[n]] .. members[first[n + 1] - 1], in facet order.
+        static void
+        Members(
+          const std::vector<uint32_t> &labels,
+          size_t nObjects,
+          std::vector<uint32_t> &first,
+          std::vector<uint32_t> &members
+        ) {
+          first.assign(nObjects + 1, 0);
+          for (auto label : labels) {
+            first[label + 1]++;
+          }
+          std::partial_sum(first.begin(), first.end(), first.begin());
+
+          members.resize(labels.size());
+          std::vector<uint32_t> cursor(first.begin(), first.end() - 1);
+          for (uint32_t i = 0; i < labels.size(); i++) {
+            members[cursor[labels[i]]++] = i;
+          }
+        }
 
-          std::memset(reinterpret_cast<char*>(&objHeader), 0, sizeof(STLHeaderT));
+
+        static void
+        Write(
+          const std::string &filename,
+          const std::vector<STLFacetT> &facets
+        ) {
+          STLHeaderT header;
+          std::memset(reinterpret_cast<char*>(&header), 0, sizeof(STLHeaderT));
           const char * IDENT = "STLB Reader/Writer";
-          std::strcpy(objHeader.m_Header, IDENT);
+          std::strcpy(header.m_Header, IDENT);
+          header.m_Facets = facets.size();
+
+          std::ofstream output{filename, std::ios::binary | std::ios::out};
+          output.write(reinterpret_cast<char*>(&header), sizeof(STLHeaderT));
+          output.write(reinterpret_cast<const char*>(facets.data()),
+                       facets.size() * sizeof(STLFacetT));
+          output.close();
+        }
 
-          size_t n = 0;
-          for (const auto& object : manifold_objects) {
-            std::stringstream outname;
-            outname << "manifold_object_" << n++ << ".stl";
 
-            std::ofstream output{outname.str().c_str(),
-              std::ios::binary | std::ios::out};
+        static void
+        Corners(
+          const STLFacetT &facet,
+          HullSTL::Point * points
+        ) {
+          for (int k = 0; k < 3; k++) {
+            points[0][k] = facet.m_Vertex1[k];
+            points[1][k] = facet.m_Vertex2[k];
+            points[2][k] = facet.m_Vertex3[k];
+          }
+        }
 
-            objHeader.m_Facets = object.size();
 
-            output.write(reinterpret_cast<char*>(&objHeader), sizeof(STLHeaderT));
+        // Drop repeated corners, keeping the first of each in place.  Points
+        // are radix sorted by a hash of their coordinates and compared
+        // exactly within each run of equal hashes.
+        static void
+        Weld(
+          std::vector<HullSTL::Point> &points,
+          int threads
+        ) {
+          std::vector<uint64_t> keys(points.size());
+          ParallelSTL::For(threads, points.size(), [&](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; i++) {
+              uint64_t key = 0;
+              for (int k = 0; k < 3; k++) {
+                uint32_t bits;
+                float value = points[i][k] + 0.0f;
+                std::memcpy(&bits, &value, sizeof(bits));
+                key = (key ^ bits) * 0x100000001b3ULL;
+                key ^= key >> 29;
+              }
+              keys[i] = key;
+            }
+          });
 
-            for (const auto& triangle : object) {
-              std::memset(reinterpret_cast<char*>(&objFacet), 0, sizeof(STLFacetT));
+          std::vector<uint32_t> order;
+          CurveSTL::Sort(keys, threads, order);
 
-              GraphSTL::Extract(
-                triangle,
-                objFacet.m_Normal,
-                objFacet.m_Vertex1,
-                objFacet.m_Vertex2,
-                objFacet.m_Vertex3,
-                objFacet.m_Attr
-              );
+          std::vector<uint8_t> repeated(points.size(), 0);
+          for (size_t i = 0, j = 0; i < order.size(); i = j) {
+            while (j < order.size() && keys[j] == keys[i]) {
+              j++;
+            }
+            for (size_t a = i + 1; a < j; a++) {
+              for (size_t b = i; b < a; b++) {
+                if (!repeated[order[b]] && points[order[a]] == points[order[b]]) {
+                  repeated[order[a]] = 1;
+                  break;
+                }
+              }
+            }
+          }
 
-              output.write(reinterpret_cast<char*>(&objFacet), sizeof(STLFacetT));
+          size_t count = 0;
+          for (size_t i = 0; i < points.size(); i++) {
+            if (!repeated[i]) {
+              points[count++] = points[i];
             }
+          }
+          points.resize(count);
+        }
 
-            output.close();
+
+        static bool
+        HullFacets(
+          const std::vector<HullSTL::Point> &points,
+          int threads,
+          std::vector<STLFacetT> &hull,
+          float &volume
+        ) {
+          std::vector<HullSTL::Face> faces;
+          if (!HullSTL::ConvexHull(points, faces, threads)) {
+            volume = 0;
+            return false;
           }
+
+          volume = HullSTL::Volume(points, faces);
+
+          hull.resize(faces.size());
+          for (size_t i = 0; i < faces.size(); i++) {
+            auto &facet = hull[i];
+            std::memset(reinterpret_cast<char*>(&facet), 0, sizeof(STLFacetT));
+            for (int k = 0; k < 3; k++) {
+              facet.m_Vertex1[k] = points[faces[i][0]][k];
+              facet.m_Vertex2[k] = points[faces[i][1]][k];
+              facet.m_Vertex3[k] = points[faces[i][2]][k];
+            }
+            Normal(facet);
+          }
+          return true;
+        }
+
+
+        static void
+        Normal(
+          STLFacetT &facet
+        ) {
+          float u[3], v[3];
+          for (int k = 0; k < 3; k++) {
+            u[k] = facet.m_Vertex2[k] - facet.m_Vertex1[k];
+            v[k] = facet.m_Vertex3[k] - facet.m_Vertex1[k];
+          }
+
+          float n[3] = {
+            u[1] * v[2] - u[2] * v[1],
+            u[2] * v[0] - u[0] * v[2],
+            u[0] * v[1] - u[1] * v[0]
+          };
+
+          float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+          for (int k = 0; k < 3; k++) {
+            facet.m_Normal[k] = length > 0 ? n[k] / length : 0;
+          }
+        }
+
+
+        static BVHSTL::Triangle
+        ToTriangle(
+          const STLFacetT &facet
+        ) {
+          return {
+            facet.m_Vertex1[0], facet.m_Vertex1[1], facet.m_Vertex1[2],
+            facet.m_Vertex2[0], facet.m_Vertex2[1], facet.m_Vertex2[2],
+            facet.m_Vertex3[0], facet.m_Vertex3[1], facet.m_Vertex3[2]
+          };
+        }
+
+
+        static bool
+        SharesVertex(
+          const std::vector<uint32_t> &weld,
+          uint32_t a,
+          uint32_t b
+        ) {
+          for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+              if (weld[3 * size_t(a) + i] == weld[3 * size_t(b) + j]) {
+                return true;
+              }
+            }
+          }
+          return false;
         }
 
-    private:
 
         STLHeaderT *
         GetHeader() {
@@ -443,6 +1232,9 @@ class STLBObj::Impl {
 
         int
         GetNFacets() {
+            if (buffer.Size() < sizeof(STLHeaderT)) {
+                return 0;
+            }
             auto header = GetHeader();
             return header->m_Facets;
         }
@@ -454,7 +1246,8 @@ class STLBObj::Impl {
         }
 
         int m_Threads;
-        std::vector<char> buffer;
+        std::string m_CacheDirectory;
+        BufferSTL::Buffer buffer;
 };
 
 
@@ -470,6 +1263,44 @@ STLBObj::STLBObj(
 ) : pimpl(new STLBObj::Impl(filename, threads)) {}
 
 
+STLBObj::STLBObj(
+    const void *data,
+    size_t length,
+    int threads
+) : pimpl(new STLBObj::Impl(data, length, threads)) {}
+
+
+STLBObj::STLBObj(
+    const STLBObj &other
+) : pimpl(new STLBObj::Impl(*other.pimpl)) {}
+
+
+bool
+STLBObj::Valid() {
+    return pimpl->Valid();
+}
+
+
+const char *
+STLBObj::Data() {
+    return pimpl->Data();
+}
+
+
+const STLFacetT *
+STLBObj::Facets(
+    size_t &count
+) {
+    return pimpl->Facets(count);
+}
+
+
+size_t
+STLBObj::Bytes() {
+    return pimpl->Bytes();
+}
+
+
 bool
 STLBObj::Dump(
     std::ostream & out
@@ -496,6 +1327,14 @@ STLBObj::Save(
 }
 
 
+bool
+STLBObj::SaveAscii(
+    const std::string &filename
+) {
+    return pimpl->SaveAscii(filename);
+}
+
+
 bool
 STLBObj::FilterX(float x) {
     return pimpl->Filter(
@@ -529,6 +1368,25 @@ STLBObj::Add(const STLFacetT &facet) {
 }
 
 
+bool
+STLBObj::Array(
+  const unsigned (&count)[3],
+  const float (&spacing)[3]
+) {
+  return pimpl->Array(count, spacing, nullptr);
+}
+
+
+bool
+STLBObj::Array(
+  const unsigned (&count)[3],
+  const float (&spacing)[3],
+  const std::string &filename
+) {
+  return pimpl->Array(count, spacing, &filename);
+}
+
+
 void
 STLBObj::Centroid(
   float &x,
@@ -558,6 +1416,22 @@ STLBObj::Rotate (
 }
 
 
+OrientSTL::OrientationT
+STLBObj::OptimizeOrientation(
+  size_t candidates
+) {
+  return pimpl->OptimizeOrientation(candidates);
+}
+
+
+void
+STLBObj::Reorder(
+  CurveSTL::Curve curve
+) {
+  pimpl->Reorder(curve);
+}
+
+
 void
 STLBObj::Scale(
   float x,
@@ -569,6 +1443,105 @@ STLBObj::Scale(
 
 
 void
-STLBObj::Split() {
-  pimpl->Split();
+STLBObj::Cache(
+  const std::string &directory
+) {
+  pimpl->Cache(directory);
+}
+
+
+size_t
+STLBObj::Intersections(
+  std::vector<STLIntersectionT> &intersections
+) {
+  return pimpl->Intersections(intersections);
+}
+
+
+size_t
+STLBObj::SplitUnique(
+  float tolerance,
+  const std::string &directory
+) {
+  return pimpl->SplitUnique(tolerance, directory);
+}
+
+
+long
+STLBObj::Cut(
+  const float (&plane)[4],
+  const std::string &directory
+) {
+  return pimpl->Cut(plane, directory);
+}
+
+
+uint64_t
+STLBObj::Hash(
+  float quantum
+) {
+  return pimpl->Hash(quantum);
+}
+
+
+void
+STLBObj::Diff(
+  STLBObj &other,
+  std::vector<STLFacetT> &removed,
+  std::vector<STLFacetT> &added,
+  float quantum
+) {
+  pimpl->Diff(*other.pimpl, quantum, removed, added);
+}
+
+
+bool
+STLBObj::Query(
+  const float *points,
+  size_t count,
+  float *distances
+) {
+  return pimpl->Query(points, count, distances);
+}
+
+
+bool
+STLBObj::Voxelize(
+  unsigned resolution,
+  VoxelSTL::GridT &grid
+) {
+  return pimpl->Voxelize(resolution, grid);
+}
+
+
+void
+STLBObj::Render(
+  RenderSTL::ImageT &image
+) {
+  pimpl->Render(image);
+}
+
+
+bool
+STLBObj::Hull(
+  float &volume
+) {
+  return pimpl->Hull(volume);
+}
+
+
+void
+STLBObj::Hulls(
+  std::vector<float> &volumes,
+  const std::string &directory
+) {
+  pimpl->Hulls(volumes, directory);
+}
+
+
+void
+STLBObj::Split(
+  const std::string &directory
+) {
+  pimpl->Split(directory);
 }
@@ -2,9 +2,14 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <iostream>
 
+#include "CurveSTL.hpp"
 #include "GraphSTL.hpp"
+#include "OrientSTL.hpp"
+#include "VoxelSTL.hpp"
+#include "RenderSTL.hpp"
 
 
 #pragma pack(push, 1)
@@ -19,6 +24,15 @@
 #pragma pack(pop)
 
 
+// A pair of intersecting facets, identified by manifold object and by facet
+// index into the facet buffer.  Equal objects indicate a self-intersection.
+typedef struct
+STLIntersection {
+    uint32_t    m_Object[2];
+    uint32_t    m_Facet[2];
+} STLIntersectionT;
+
+
 class STLBObj {
     public:
        ~STLBObj();
@@ -27,12 +41,33 @@ class STLBObj {
 
         STLBObj(const std::string &filename, int threads = 2);
 
+        STLBObj(const void *data, size_t length, int threads = 2);
+
+        STLBObj(const STLBObj &other);
+
+        bool
+        Valid();
+
+        size_t
+        Bytes();
+
+        // The STLB image, Bytes() long, and its facets; valid until the
+        // object is next modified.
+        const char *
+        Data();
+
+        const STLFacetT *
+        Facets(size_t &count);
+
         bool
         Dump(std::ostream & out = std::cout);
 
         bool
         Save(const std::string &filename);
 
+        bool
+        SaveAscii(const std::string &filename);
+
         bool
         Translate(float x, float y, float z);
 
@@ -48,9 +83,28 @@ class STLBObj {
         bool
         Add(const STLFacetT &facet);
 
+        bool
+        Array(
+          const unsigned (&count)[3],
+          const float (&spacing)[3]
+        );
+
+        bool
+        Array(
+          const unsigned (&count)[3],
+          const float (&spacing)[3],
+          const std::string &filename
+        );
+
         void
         Rotate(float x, float y, float z);
 
+        OrientSTL::OrientationT
+        OptimizeOrientation(size_t candidates = 4096);
+
+        void
+        Reorder(CurveSTL::Curve curve);
+
         void
         Scale(float x, float y, float z);
 
@@ -65,7 +119,70 @@ class STLBObj {
         );
 
         void
-        Split();
+        Split(const std::string &directory = ".");
+
+        // Split, writing identical parts once plus manifold_instances.txt
+        // with every object's part and transform; returns the part count.
+        size_t
+        SplitUnique(
+          float tolerance = 1e-4f,
+          const std::string &directory = "."
+        );
+
+        void
+        Cache(const std::string &directory);
+
+        size_t
+        Intersections(std::vector<STLIntersectionT> &intersections);
+
+        // Write the halves on either side of the plane { nx, ny, nz, d } as
+        // closed meshes, cut_upper.stl and cut_lower.stl.  Returns the number
+        // of cap loops, -1 for a zero normal, or -2, writing nothing, when
+        // the plane does not cross the mesh.
+        long
+        Cut(
+          const float (&plane)[4],
+          const std::string &directory = "."
+        );
+
+        // Geometry hash independent of facet order, starting vertex and
+        // header, with vertices snapped to a grid of quantum.
+        uint64_t
+        Hash(float quantum = 1e-4f);
+
+        // Facets only in this object (removed) and only in other (added),
+        // compared as multisets of snapped geometry.
+        void
+        Diff(
+          STLBObj &other,
+          std::vector<STLFacetT> &removed,
+          std::vector<STLFacetT> &added,
+          float quantum = 1e-4f
+        );
+
+        // Signed distance from each of count points (x, y, z packed) to the
+        // surface, negative inside.  False if there are no facets.
+        bool
+        Query(
+          const float *points,
+          size_t count,
+          float *distances
+        );
+
+        bool
+        Voxelize(unsigned resolution, VoxelSTL::GridT &grid);
+
+        void
+        Render(RenderSTL::ImageT &image);
+
+        bool
+        Hull(float &volume);
+
+        void
+        Hulls(
+          std::vector<float> &volumes,
+          const std::string &directory = "."
+        );
 
 
     private:
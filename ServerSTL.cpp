@@ -0,0 +1,458 @@
+#include "ServerSTL.hpp"
+
+#include <list>
+#include <mutex>
+#include <queue>
+#include <future>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+
+#include <cmath>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "STLBIfc.hpp"
+#include "OpsSTL.hpp"
+
+
+namespace ServerSTL {
+
+
+class Pool {
+public:
+  Pool(int threads) {
+    for (int i = 0; i < std::max(threads, 1); i++) {
+      m_Workers.emplace_back([this] { Run(); });
+    }
+  }
+
+
+  ~Pool() {
+    {
+      std::lock_guard<std::mutex> lock(m_Lock);
+      m_Stop = true;
+    }
+    m_Ready.notify_all();
+    for (auto& worker : m_Workers) {
+      worker.join();
+    }
+  }
+
+
+  std::future<std::string>
+  Submit(
+    std::function<std::string()> work
+  ) {
+    auto task = std::make_shared<std::packaged_task<std::string()>>(work);
+    auto result = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(m_Lock);
+      m_Tasks.push([task] { (*task)(); });
+    }
+    m_Ready.notify_one();
+    return result;
+  }
+
+
+private:
+  void
+  Run() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(m_Lock);
+        m_Ready.wait(lock, [this] { return m_Stop || !m_Tasks.empty(); });
+        if (m_Stop && m_Tasks.empty()) {
+          return;
+        }
+        task = std::move(m_Tasks.front());
+        m_Tasks.pop();
+      }
+      task();
+    }
+  }
+
+  bool m_Stop = false;
+  std::mutex m_Lock;
+  std::condition_variable m_Ready;
+  std::queue<std::function<void()>> m_Tasks;
+  std::vector<std::thread> m_Workers;
+};
+
+
+// A cached object along with the statistics derived from it.  The object
+// itself is never modified once cached; transforms operate on a copy.
+class Entry {
+public:
+  using EntryPtr = std::shared_ptr<Entry>;
+
+  Entry(
+    const std::string& filename,
+    const struct stat& info
+  ) :
+    m_Object(std::make_shared<STLBObj>(filename, 1)),
+    m_Bytes(m_Object->Bytes()),
+    m_Size(info.st_size),
+    m_MTime(info.st_mtim) {
+    if (!m_Object->Valid()) {
+      throw std::runtime_error("Invalid or Corrupt STLB: " + filename);
+    }
+  }
+
+
+  bool
+  Current(
+    const struct stat& info
+  ) {
+    return info.st_size == m_Size &&
+           info.st_mtim.tv_sec == m_MTime.tv_sec &&
+           info.st_mtim.tv_nsec == m_MTime.tv_nsec;
+  }
+
+
+  std::string
+  Stats() {
+    std::lock_guard<std::mutex> lock(m_Lock);
+    if (m_Stats.empty()) {
+      float x[2], y[2], z[2], centroid[3];
+      m_Object->MinMax(x, y, z);
+      m_Object->Centroid(centroid[0], centroid[1], centroid[2]);
+
+      std::ostringstream out;
+      out << "minmax "
+          << x[0] << "," << x[1] << ","
+          << y[0] << "," << y[1] << ","
+          << z[0] << "," << z[1]
+          << " centroid "
+          << centroid[0] << "," << centroid[1] << "," << centroid[2];
+      m_Stats = out.str();
+    }
+    return m_Stats;
+  }
+
+  std::shared_ptr<STLBObj> m_Object;
+  size_t m_Bytes;
+
+private:
+  off_t m_Size;
+  struct timespec m_MTime;
+  std::mutex m_Lock;
+  std::string m_Stats;
+};
+
+
+class Cache {
+public:
+  Cache(size_t budget) : m_Budget(budget) {}
+
+
+  Entry::EntryPtr
+  Get(
+    const std::string& filename
+  ) {
+    struct stat info;
+    if (stat(filename.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+      throw std::runtime_error("Invalid filename: " + filename);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_Lock);
+      auto found = m_Entries.find(filename);
+      if (found != m_Entries.end() && found->second.first->Current(info)) {
+        m_LRU.splice(m_LRU.begin(), m_LRU, found->second.second);
+        return found->second.first;
+      }
+    }
+
+    // Load outside of the lock, a concurrent miss on the same file costs a
+    // duplicate read but never blocks hits on other files.
+    auto entry = std::make_shared<Entry>(filename, info);
+
+    std::lock_guard<std::mutex> lock(m_Lock);
+    Remove(filename);
+    m_LRU.push_front(filename);
+    m_Entries[filename] = std::make_pair(entry, m_LRU.begin());
+    m_Bytes += entry->m_Bytes;
+
+    while (m_Bytes > m_Budget && m_LRU.size() > 1) {
+      Remove(m_LRU.back());
+    }
+
+    return entry;
+  }
+
+
+  void
+  Evict(
+    const std::string& filename
+  ) {
+    std::lock_guard<std::mutex> lock(m_Lock);
+    Remove(filename);
+  }
+
+
+private:
+  void
+  Remove(
+    const std::string& filename
+  ) {
+    auto found = m_Entries.find(filename);
+    if (found != m_Entries.end()) {
+      m_Bytes -= found->second.first->m_Bytes;
+      m_LRU.erase(found->second.second);
+      m_Entries.erase(found);
+    }
+  }
+
+  size_t m_Budget;
+  size_t m_Bytes = 0;
+  std::mutex m_Lock;
+  std::list<std::string> m_LRU;
+  std::unordered_map<
+    std::string,
+    std::pair<Entry::EntryPtr, std::list<std::string>::iterator>
+  > m_Entries;
+};
+
+
+static std::string
+Execute(
+  Cache& cache,
+  const std::string& command
+) {
+  std::istringstream ss(command);
+  std::vector<std::string> args;
+  std::string token;
+  while (ss >> token) {
+    args.push_back(token);
+  }
+
+  if (args.size() == 2 && args[0] == "stats") {
+    return "OK " + cache.Get(args[1])->Stats();
+  }
+
+  if (args.size() == 2 && args[0] == "evict") {
+    cache.Evict(args[1]);
+    return "OK";
+  }
+
+  if (args.size() == 3 && args[0] == "save") {
+    if (!cache.Get(args[1])->m_Object->Save(args[2])) {
+      throw std::runtime_error("Unable to write: " + args[2]);
+    }
+    return "OK";
+  }
+
+  if (args.size() == 3 && args[0] == "split") {
+    cache.Get(args[1])->m_Object->Split(args[2]);
+    return "OK";
+  }
+
+  if (args.size() >= 3 && args[0] == "transform") {
+    STLBObj object(*cache.Get(args[1])->m_Object);
+
+    for (size_t i = 3; i < args.size(); i++) {
+      OpsSTL::Apply(object, args[i]);
+    }
+
+    if (!object.Save(args[2])) {
+      throw std::runtime_error("Unable to write: " + args[2]);
+    }
+    return "OK";
+  }
+
+  throw std::runtime_error("Unknown command: " + command);
+}
+
+
+static bool
+SendAll(
+  int fd,
+  const std::string& data
+) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    auto n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      return false;
+    }
+    sent += n;
+  }
+  return true;
+}
+
+
+static void
+Connection(
+  int fd,
+  Cache& cache,
+  Pool& pool
+) {
+  std::string pending;
+  char chunk[4096];
+  bool open = true;
+
+  while (open) {
+    std::vector<std::string> batch;
+    bool complete = false;
+
+    while (!complete) {
+      size_t newline;
+      while (!complete && (newline = pending.find('\n')) != std::string::npos) {
+        auto line = pending.substr(0, newline);
+        pending.erase(0, newline + 1);
+        if (!line.empty() && line.back() == '\r') {
+          line.pop_back();
+        }
+
+        if (line.empty()) {
+          complete = !batch.empty();
+        } else {
+          batch.push_back(line);
+        }
+      }
+
+      if (complete) {
+        break;
+      }
+
+      auto n = recv(fd, chunk, sizeof(chunk), 0);
+      if (n <= 0) {
+        if (!pending.empty()) {
+          batch.push_back(pending);
+        }
+        open = false;
+        complete = true;
+      } else {
+        pending.append(chunk, n);
+      }
+    }
+
+    std::vector<std::future<std::string>> results;
+    for (const auto& command : batch) {
+      results.push_back(pool.Submit([&cache, command] {
+        return Execute(cache, command);
+      }));
+    }
+
+    std::string response;
+    for (auto& result : results) {
+      try {
+        response += result.get();
+      } catch (const std::exception& ex) {
+        response += std::string("ERR ") + ex.what();
+      }
+      response += "\n";
+    }
+
+    if (!response.empty() && !SendAll(fd, response)) {
+      open = false;
+    }
+  }
+
+  close(fd);
+}
+
+
+// Clear the way for bind: nothing at path, or a socket left behind by a
+// server that is gone, which is removed.  Anything else is left alone.
+static bool
+Stale(
+  const std::string& socket_path,
+  const struct sockaddr_un& address
+) {
+  struct stat info;
+  if (lstat(socket_path.c_str(), &info) != 0) {
+    return errno == ENOENT;
+  }
+
+  if (!S_ISSOCK(info.st_mode)) {
+    std::cerr << "ERROR: Not a socket: " << socket_path << std::endl;
+    return false;
+  }
+
+  int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+  bool listening = probe >= 0 &&
+    connect(probe, reinterpret_cast<const struct sockaddr*>(&address), sizeof(address)) == 0;
+  if (probe >= 0) {
+    close(probe);
+  }
+
+  if (listening) {
+    std::cerr << "ERROR: Socket in use: " << socket_path << std::endl;
+    return false;
+  }
+
+  return unlink(socket_path.c_str()) == 0;
+}
+
+
+int
+Serve(
+  const std::string& socket_path,
+  size_t cache_bytes,
+  int threads
+) {
+  struct sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    std::cerr << "ERROR: Socket path too long: " << socket_path << std::endl;
+    return -1;
+  }
+  std::strcpy(address.sun_path, socket_path.c_str());
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    std::cerr << "ERROR: socket: " << std::strerror(errno) << std::endl;
+    return -1;
+  }
+
+  if (!Stale(socket_path, address)) {
+    close(listener);
+    return -1;
+  }
+
+  if (bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(listener, SOMAXCONN) != 0) {
+    std::cerr << "ERROR: bind: " << socket_path << ": " << std::strerror(errno) << std::endl;
+    close(listener);
+    return -1;
+  }
+
+  Cache cache(cache_bytes);
+  Pool pool(threads);
+
+  for (;;) {
+    int fd = accept(listener, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::cerr << "ERROR: accept: " << std::strerror(errno) << std::endl;
+      break;
+    }
+
+    std::thread(Connection, fd, std::ref(cache), std::ref(pool)).detach();
+  }
+
+  close(listener);
+  unlink(socket_path.c_str());
+  return -1;
+}
+
+
+} /* namespace ServerSTL */
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+
+namespace ServerSTL {
+
+
+// Run a resident server on a Unix domain socket.  Loaded STLBObj instances
+// are kept in an LRU cache bounded by cache_bytes and command batches are
+// executed concurrently on a pool of threads workers.
+//
+// Protocol: one command per line, a batch is terminated by an empty line (or
+// by closing the write side of the socket).  Every command of the batch
+// receives exactly one response line, in order, starting with "OK" or "ERR".
+//
+//   stats     <input>
+//   save      <input> <output>
+//   split     <input> <directory>
+//   transform <input> <output> [rotate=x,y,z] [scale=x,y,z] [translate=x,y,z]
+//   evict     <input>
+int
+Serve(
+  const std::string& socket_path,
+  size_t cache_bytes,
+  int threads
+);
+
+
+} /* namespace ServerSTL */
@@ -0,0 +1,446 @@
+#include "VoxelSTL.hpp"
+
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <algorithm>
+
+#include "STLBIfc.hpp"
+#include "ParallelSTL.hpp"
+
+#define VOXEL_MAGIC     0x42584f56u   // "VOXB"
+#define VOXEL_VERSION   1
+#define VOXEL_SUBPIXEL_BITS 8
+#define VOXEL_SUBPIXEL  (1 << VOXEL_SUBPIXEL_BITS)   // Fixed point steps per voxel in X and Y.
+
+
+namespace VoxelSTL {
+
+
+#pragma pack(push, 1)
+  typedef struct
+  VoxelHeader {
+    uint32_t  m_Magic;
+    uint32_t  m_Version;
+    uint32_t  m_Encoding;       // 0 raw column words, 1 run lengths.
+    uint32_t  m_Size[3];
+    float     m_Origin[3];
+    float     m_Voxel;
+    uint64_t  m_Filled;
+  } VoxelHeaderT;
+#pragma pack(pop)
+
+
+typedef struct
+Crossing {
+  uint32_t  m_Column;   // Within the band.
+  float     m_Z;        // In voxels.
+} CrossingT;
+
+
+// A facet projected on XY in fixed point, counter-clockwise, with its Z in
+// voxels.  Returns false when the projection has no area.
+static bool
+Project(
+  const STLFacetT& facet,
+  const GridT& grid,
+  int64_t (&x)[3],
+  int64_t (&y)[3],
+  float (&z)[3]
+) {
+  const float* v[3] = { facet.m_Vertex1, facet.m_Vertex2, facet.m_Vertex3 };
+  for (int n = 0; n < 3; n++) {
+    x[n] = std::llround(double(v[n][0] - grid.m_Origin[0]) / grid.m_Voxel * VOXEL_SUBPIXEL);
+    y[n] = std::llround(double(v[n][1] - grid.m_Origin[1]) / grid.m_Voxel * VOXEL_SUBPIXEL);
+    z[n] = (v[n][2] - grid.m_Origin[2]) / grid.m_Voxel;
+  }
+
+  int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+  if (area == 0) {
+    return false;
+  }
+  if (area < 0) {
+    std::swap(x[1], x[2]);
+    std::swap(y[1], y[2]);
+    std::swap(z[1], z[2]);
+  }
+  return true;
+}
+
+
+// First and last column centre, n * SUBPIXEL + SUBPIXEL / 2, within [lo, hi].
+static void
+Centres(
+  int64_t lo,
+  int64_t hi,
+  uint32_t size,
+  int64_t& first,
+  int64_t& last
+) {
+  const int64_t half = VOXEL_SUBPIXEL / 2;
+  first = std::max<int64_t>(0, (lo - half + VOXEL_SUBPIXEL - 1) >> VOXEL_SUBPIXEL_BITS);
+  last = std::min<int64_t>(int64_t(size) - 1, (hi - half) >> VOXEL_SUBPIXEL_BITS);
+}
+
+
+static void
+Rows(
+  const int64_t (&y)[3],
+  const GridT& grid,
+  int64_t& first,
+  int64_t& last
+) {
+  Centres(std::min({ y[0], y[1], y[2] }), std::max({ y[0], y[1], y[2] }),
+          grid.m_Size[1], first, last);
+}
+
+
+// Columns of rows [r0, r1) whose centre the facet covers, with the top-left
+// rule deciding centres on an edge.
+static void
+Rasterize(
+  const STLFacetT& facet,
+  const GridT& grid,
+  int64_t r0,
+  int64_t r1,
+  std::vector<CrossingT>& crossings
+) {
+  int64_t x[3], y[3];
+  float z[3];
+  if (!Project(facet, grid, x, y, z)) {
+    return;
+  }
+
+  int64_t j0, j1, i0, i1;
+  Rows(y, grid, j0, j1);
+  j0 = std::max(j0, r0);
+  j1 = std::min(j1, r1 - 1);
+  Centres(std::min({ x[0], x[1], x[2] }), std::max({ x[0], x[1], x[2] }),
+          grid.m_Size[0], i0, i1);
+
+  int64_t dx[3], dy[3];
+  bool topLeft[3];
+  for (int e = 0; e < 3; e++) {
+    int n = (e + 1) % 3;
+    dx[e] = x[n] - x[e];
+    dy[e] = y[n] - y[e];
+    topLeft[e] = dy[e] < 0 || (dy[e] == 0 && dx[e] < 0);
+  }
+
+  double area = double(dx[0]) * double(y[2] - y[0]) - double(dy[0]) * double(x[2] - x[0]);
+
+  for (int64_t j = j0; j <= j1; j++) {
+    int64_t py = j * VOXEL_SUBPIXEL + VOXEL_SUBPIXEL / 2;
+    for (int64_t i = i0; i <= i1; i++) {
+      int64_t px = i * VOXEL_SUBPIXEL + VOXEL_SUBPIXEL / 2;
+
+      int64_t w[3];
+      bool inside = true;
+      for (int e = 0; e < 3 && inside; e++) {
+        w[e] = dx[e] * (py - y[e]) - dy[e] * (px - x[e]);
+        inside = w[e] > 0 || (w[e] == 0 && topLeft[e]);
+      }
+      if (!inside) {
+        continue;
+      }
+
+      // w[e] is opposite vertex (e + 2) % 3.
+      float depth = float((w[1] * double(z[0]) + w[2] * double(z[1]) + w[0] * double(z[2])) / area);
+      crossings.push_back({ uint32_t((j - r0) * grid.m_Size[0] + i), depth });
+    }
+  }
+}
+
+
+// Set bits [k0, k1) of a column.
+static void
+Fill(
+  uint64_t* column,
+  int64_t k0,
+  int64_t k1
+) {
+  while (k0 < k1) {
+    int64_t word = k0 >> 6;
+    int64_t end = std::min(k1, (word + 1) << 6);
+    int bits = int(end - k0);
+    uint64_t mask = bits == 64 ? ~0ULL : (((1ULL << bits) - 1) << (k0 & 63));
+    column[word] |= mask;
+    k0 = end;
+  }
+}
+
+
+bool
+Voxelize(
+  const STLFacet* facets,
+  size_t count,
+  const float (&x)[2],
+  const float (&y)[2],
+  const float (&z)[2],
+  unsigned resolution,
+  int threads,
+  GridT& grid
+) {
+  float extent[3] = { x[1] - x[0], y[1] - y[0], z[1] - z[0] };
+  float longest = std::max({ extent[0], extent[1], extent[2] });
+  if (count == 0 || resolution == 0 || !(longest > 0)) {
+    return false;
+  }
+
+  grid.m_Voxel = longest / resolution;
+  grid.m_Origin[0] = x[0];
+  grid.m_Origin[1] = y[0];
+  grid.m_Origin[2] = z[0];
+  for (int k = 0; k < 3; k++) {
+    grid.m_Size[k] = std::clamp<uint32_t>(uint32_t(std::ceil(extent[k] / grid.m_Voxel)),
+                                          1, resolution);
+  }
+  grid.m_Words = (grid.m_Size[2] + 63) / 64;
+  grid.m_Bits.assign(size_t(grid.m_Size[0]) * grid.m_Size[1] * grid.m_Words, 0);
+
+  // Rows are split in bands, each filled by one thread.
+  const uint32_t nx = grid.m_Size[0], ny = grid.m_Size[1];
+  size_t nBands = std::min<size_t>(ny, 8 * size_t(std::max(threads, 1)));
+  size_t rowsPerBand = (ny + nBands - 1) / nBands;
+  nBands = (ny + rowsPerBand - 1) / rowsPerBand;
+
+  // Bin facets by band: count per worker, then scatter at prefix offsets.
+  int nWorkers = ParallelSTL::Workers(threads, count);
+  std::vector<size_t> counts(size_t(nWorkers) * nBands, 0);
+  auto bands = [&](size_t f, int64_t& b0, int64_t& b1) {
+    int64_t px[3], py[3];
+    float pz[3];
+    int64_t j0, j1;
+    if (!Project(facets[f], grid, px, py, pz)) {
+      return false;
+    }
+    Rows(py, grid, j0, j1);
+    if (j1 < j0) {
+      return false;
+    }
+    b0 = j0 / rowsPerBand;
+    b1 = j1 / rowsPerBand;
+    return true;
+  };
+
+  ParallelSTL::For(threads, count, [&](size_t begin, size_t end, int thread) {
+    size_t* mine = &counts[size_t(thread) * nBands];
+    for (size_t f = begin; f < end; f++) {
+      int64_t b0, b1;
+      if (bands(f, b0, b1)) {
+        for (int64_t b = b0; b <= b1; b++) {
+          mine[b]++;
+        }
+      }
+    }
+  });
+
+  std::vector<size_t> first(nBands + 1, 0);
+  std::vector<size_t> offsets(counts.size());
+  size_t total = 0;
+  for (size_t b = 0; b < nBands; b++) {
+    first[b] = total;
+    for (int t = 0; t < nWorkers; t++) {
+      offsets[size_t(t) * nBands + b] = total;
+      total += counts[size_t(t) * nBands + b];
+    }
+  }
+  first[nBands] = total;
+
+  std::vector<uint32_t> members(total);
+  ParallelSTL::For(threads, count, [&](size_t begin, size_t end, int thread) {
+    size_t* next = &offsets[size_t(thread) * nBands];
+    for (size_t f = begin; f < end; f++) {
+      int64_t b0, b1;
+      if (bands(f, b0, b1)) {
+        for (int64_t b = b0; b <= b1; b++) {
+          members[next[b]++] = f;
+        }
+      }
+    }
+  });
+
+  ParallelSTL::For(threads, nBands, [&](size_t begin, size_t end, int) {
+    std::vector<CrossingT> crossings;
+    std::vector<CrossingT> sorted;
+    std::vector<uint32_t> start;
+
+    for (size_t b = begin; b < end; b++) {
+      int64_t r0 = b * rowsPerBand;
+      int64_t r1 = std::min<int64_t>(ny, r0 + rowsPerBand);
+      size_t columns = size_t(r1 - r0) * nx;
+
+      crossings.clear();
+      for (size_t m = first[b]; m < first[b + 1]; m++) {
+        Rasterize(facets[members[m]], grid, r0, r1, crossings);
+      }
+
+      // Counting sort by column.
+      start.assign(columns + 1, 0);
+      for (auto& c : crossings) {
+        start[c.m_Column + 1]++;
+      }
+      for (size_t c = 0; c < columns; c++) {
+        start[c + 1] += start[c];
+      }
+      sorted.resize(crossings.size());
+      for (auto& c : crossings) {
+        sorted[start[c.m_Column]++] = c;
+      }
+      for (size_t c = columns; c > 0; c--) {
+        start[c] = start[c - 1];
+      }
+      start[0] = 0;
+
+      for (size_t c = 0; c < columns; c++) {
+        auto lo = sorted.begin() + start[c];
+        auto hi = sorted.begin() + start[c + 1];
+        std::sort(lo, hi, [](const CrossingT& p, const CrossingT& q) { return p.m_Z < q.m_Z; });
+
+        uint64_t* column = &grid.m_Bits[(size_t(r0) * nx + c) * grid.m_Words];
+        // An unpaired last crossing belongs to an open mesh and is dropped.
+        for (auto it = lo; it + 1 < hi; it += 2) {
+          int64_t k0 = std::max<int64_t>(0, int64_t(std::ceil(it[0].m_Z - 0.5f)));
+          int64_t k1 = std::min<int64_t>(grid.m_Size[2], int64_t(std::ceil(it[1].m_Z - 0.5f)));
+          Fill(column, k0, k1);
+        }
+      }
+    }
+  }, 1);
+
+  return true;
+}
+
+
+size_t
+Filled(
+  const GridT& grid,
+  int threads
+) {
+  int nWorkers = ParallelSTL::Workers(threads, grid.m_Bits.size());
+  std::vector<size_t> filled(nWorkers, 0);
+
+  ParallelSTL::For(threads, grid.m_Bits.size(), [&](size_t begin, size_t end, int thread) {
+    size_t n = 0;
+    for (size_t w = begin; w < end; w++) {
+      n += std::popcount(grid.m_Bits[w]);
+    }
+    filled[thread] = n;
+  });
+
+  size_t total = 0;
+  for (auto n : filled) {
+    total += n;
+  }
+  return total;
+}
+
+
+// Run lengths over columns [begin, end), starting with an empty run.
+static void
+Runs(
+  const GridT& grid,
+  size_t begin,
+  size_t end,
+  std::vector<uint64_t>& runs
+) {
+  runs.assign(1, 0);
+  bool value = false;
+
+  auto extend = [&](bool bit, uint64_t length) {
+    if (bit != value) {
+      runs.push_back(0);
+      value = bit;
+    }
+    runs.back() += length;
+  };
+
+  for (size_t c = begin; c < end; c++) {
+    const uint64_t* column = &grid.m_Bits[c * grid.m_Words];
+    for (size_t w = 0; w < grid.m_Words; w++) {
+      int bits = int(std::min<uint64_t>(64, grid.m_Size[2] - w * 64));
+      uint64_t mask = bits == 64 ? ~0ULL : (1ULL << bits) - 1;
+      uint64_t word = column[w];
+
+      if (word == 0 || word == mask) {
+        extend(word != 0, bits);
+        continue;
+      }
+
+      for (int k = 0; k < bits;) {
+        bool bit = (word >> k) & 1;
+        uint64_t rest = bit ? ~word >> k : word >> k;
+        int length = std::min(bits - k, rest ? std::countr_zero(rest) : 64);
+        extend(bit, length);
+        k += length;
+      }
+    }
+  }
+}
+
+
+bool
+Save(
+  const std::string& filename,
+  const GridT& grid,
+  bool rle,
+  int threads
+) {
+  VoxelHeaderT header = {
+    VOXEL_MAGIC, VOXEL_VERSION, rle ? 1u : 0u,
+    { grid.m_Size[0], grid.m_Size[1], grid.m_Size[2] },
+    { grid.m_Origin[0], grid.m_Origin[1], grid.m_Origin[2] },
+    grid.m_Voxel, Filled(grid, threads)
+  };
+
+  std::ofstream output{filename, std::ios::binary | std::ios::out};
+  output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  if (!rle) {
+    output.write(reinterpret_cast<const char*>(grid.m_Bits.data()),
+                 grid.m_Bits.size() * sizeof(uint64_t));
+    output.close();
+    return bool(output);
+  }
+
+  size_t columns = size_t(grid.m_Size[0]) * grid.m_Size[1];
+  int nWorkers = ParallelSTL::Workers(threads, columns, 1024);
+  std::vector<std::vector<uint64_t>> parts(nWorkers);
+
+  ParallelSTL::For(threads, columns, [&](size_t begin, size_t end, int thread) {
+    Runs(grid, begin, end, parts[thread]);
+  }, 1024);
+
+  // Join the parts, merging the run across each seam.
+  std::vector<uint64_t> runs;
+  for (auto& part : parts) {
+    size_t n = 0;
+    if (runs.size() % 2 == 1) {
+      runs.back() += part[0];
+      n = 1;
+    } else if (!runs.empty() && part[0] == 0 && part.size() > 1) {
+      runs.back() += part[1];
+      n = 2;
+    }
+    runs.insert(runs.end(), part.begin() + n, part.end());
+  }
+
+  // Runs too long for 32 bits continue after a zero length opposite run.
+  std::vector<uint32_t> lengths;
+  lengths.reserve(runs.size());
+  for (auto run : runs) {
+    while (run > UINT32_MAX) {
+      lengths.push_back(UINT32_MAX);
+      lengths.push_back(0);
+      run -= UINT32_MAX;
+    }
+    lengths.push_back(uint32_t(run));
+  }
+
+  output.write(reinterpret_cast<const char*>(lengths.data()), lengths.size() * sizeof(uint32_t));
+  output.close();
+  return bool(output);
+}
+
+
+} /* namespace VoxelSTL */
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct STLFacet;
+
+namespace VoxelSTL {
+
+
+// Occupancy grid.  Voxel (i, j, k) spans origin + voxel * [i, i+1) and so on
+// along each axis.  Bits are stored one Z column at a time, X fastest then Y,
+// each column padded to m_Words 64 bit words with bit k of the column in
+// word k / 64, bit k % 64.
+typedef struct
+Grid {
+  uint32_t              m_Size[3];
+  float                 m_Origin[3];
+  float                 m_Voxel;
+  size_t                m_Words;
+  std::vector<uint64_t> m_Bits;
+} GridT;
+
+
+// Rasterize a closed mesh over bounds, resolution voxels along its longest
+// side.  Facets are binned by rows of Y, rows are filled in parallel: each
+// facet records where it crosses the centre line of the Z columns it covers,
+// and each column is filled between alternate crossings.  Crossings are
+// found in fixed point so a column through a shared edge or vertex is
+// counted once.  Returns false on empty or degenerate bounds.
+bool
+Voxelize(
+  const STLFacet* facets,
+  size_t count,
+  const float (&x)[2],
+  const float (&y)[2],
+  const float (&z)[2],
+  unsigned resolution,
+  int threads,
+  GridT& grid
+);
+
+
+// Number of filled voxels.
+size_t
+Filled(
+  const GridT& grid,
+  int threads
+);
+
+
+// Write grid to filename: a VoxelHeaderT, then either the column words as
+// stored, or (rle) uint32 run lengths over the unpadded columns in the same
+// order, alternating empty and filled and starting with empty.
+bool
+Save(
+  const std::string& filename,
+  const GridT& grid,
+  bool rle,
+  int threads
+);
+
+
+} /* namespace VoxelSTL */
@@ -0,0 +1,16 @@
+#!/bin/sh
+# --array: copies are laid out at the part's size plus spacing, and later
+# operations see the whole array.
+. "$(dirname "$0")/lib.sh"
+
+$STL box 0,0,0 2,2,2 part.stl
+"$STOOL" --input part.stl --array 3,2,1 --spacing 1,1,0 --output plate.stl
+expect "facets" "$($STL facets plate.stl)" "72"
+expect "volume" "$($STL volume plate.stl)" "48.0000"
+expect "bounds" "$("$STOOL" --input plate.stl --minmax | tr '\n' ' ')" \
+  "X min: 0, X max: 8 Y min: 0, X max: 5 Z min: 0, X max: 2 "
+
+expect "hash of the array" "$("$STOOL" --input part.stl --array 3,2,1 --spacing 1,1,0 --hash)" \
+  "$("$STOOL" --input plate.stl --hash)"
+
+fails "two counts" "$STOOL" --input part.stl --array 3,2 --spacing 1,1,0 --output bad.stl
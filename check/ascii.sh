@@ -0,0 +1,27 @@
+#!/bin/sh
+# --ascii and --dump: the text does not depend on the thread count, ASCII
+# reads back to the same floats, and a dump lists every facet.
+. "$(dirname "$0")/lib.sh"
+
+# 20000 facets, more than one 16384 facet chunk.
+$STL torus 10 3.3 100 torus.stl
+mkdir one four
+"$STOOL" --input torus.stl --output one/torus.stl --ascii --threads 1
+"$STOOL" --input torus.stl --output four/torus.stl --ascii --threads 4
+cmp one/torus.stl four/torus.stl || fail "ascii differs across threads"
+expect "solid" "$(head -1 one/torus.stl)" "solid torus"
+expect "end" "$(tail -1 one/torus.stl)" "endsolid torus"
+$STL join back.stl one/torus.stl
+cmp back.stl torus.stl || fail "ascii does not read back to the same floats"
+
+"$STOOL" --input torus.stl --dump --threads 1 > one.dump
+"$STOOL" --input torus.stl --dump --threads 4 > four.dump
+cmp one.dump four.dump || fail "dump differs across threads"
+expect "dump facets" "$(grep -c '^Facet:' one.dump)" "20000"
+expect "dump lines" "$(wc -l < one.dump)" "$((2 + 5 * 20000))"
+
+# The dump stops at the first facet with a non-zero attribute, as it always has.
+$STL box 0,0,0 1,2,3 box.stl
+printf '\001' | dd of=box.stl bs=1 seek=$((84 + 50 * 5 + 48)) conv=notrunc 2> /dev/null
+"$STOOL" --input box.stl --dump > box.dump || true
+expect "attribute stop" "$(tail -2 box.dump | tr '\n' ' ')" "Facet: 5 Invalid or Corrupt STLB. "
@@ -0,0 +1,19 @@
+#!/bin/sh
+# Facet storage: files round trip byte for byte, a header-only STL is a
+# valid empty mesh, and anything shorter is rejected.
+. "$(dirname "$0")/lib.sh"
+
+$STL torus 10 3 48 torus.stl
+"$STOOL" --input torus.stl --output copy.stl
+expect "round trip" "$(cmp torus.stl copy.stl && echo same)" "same"
+
+"$STOOL" --input torus.stl --output turned.stl --rotate 0,0,90
+"$STOOL" --input turned.stl --output back.stl --rotate 0,0,-90
+expect "rotate volume" "$($STL volume back.stl)" "$($STL volume torus.stl)"
+
+$STL join empty.stl
+expect "header only" "$("$STOOL" --diff empty.stl torus.stl | head -1)" "Removed facets: 0"
+
+printf 'garbage' > short.stl
+fails "short file" "$STOOL" --diff torus.stl short.stl
+fails "short first file" "$STOOL" --diff short.stl torus.stl
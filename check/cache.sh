@@ -0,0 +1,29 @@
+#!/bin/sh
+# --cache-dir: topology is stored under missing parent directories in the
+# .topo layout, a hit splits the same as a miss, and an unusable cache
+# directory is reported once without failing the split.
+. "$(dirname "$0")/lib.sh"
+
+$STL sphere 5 16 a.stl
+$STL box 20,0,0 22,2,2 b.stl
+$STL torus 10 3 16 c.stl
+$STL join plate.stl a.stl b.stl c.stl
+facets=$($STL facets plate.stl)
+
+mkdir plain miss hit
+(cd plain && "$STOOL" --input ../plate.stl --split)
+(cd miss && "$STOOL" --input ../plate.stl --split --cache-dir "$WORK/cache/nested/stool")
+(cd hit && "$STOOL" --input ../plate.stl --split --cache-dir "$WORK/cache/nested/stool")
+expect "miss" "$(cd miss && cksum manifold_* | sort)" "$(cd plain && cksum manifold_* | sort)"
+expect "hit" "$(cd hit && cksum manifold_* | sort)" "$(cd plain && cksum manifold_* | sort)"
+
+# 24 byte header ("TOPT", version 1, content hash, facets), then a label
+# and three weld ids per facet.
+topo=$(ls cache/nested/stool/*.topo)
+expect "magic" "$(head -c 4 $topo)" "TOPT"
+expect "layout" "$(wc -c < $topo)" "$((24 + 16 * facets))"
+
+touch blocked
+"$STOOL" --input plate.stl --check-intersections --cache-dir "$WORK/blocked/stool" > report 2> errors
+expect "report" "$(tail -1 report)" "Intersections: 0"
+expect "reported once" "$(grep -c 'Cache ERROR' errors)" "1"
@@ -0,0 +1,42 @@
+#!/bin/sh
+# --cut: both halves close and their volumes add up, facets lying in the
+# plane go to the half they bound, a plane that misses is rejected, and a
+# large cap loop is not quadratic.
+. "$(dirname "$0")/lib.sh"
+
+# halves <input> <plane> <upper volume> <lower volume>
+halves() {
+  "$STOOL" --input $1 --cut $2 > /dev/null
+  expect "$1 $2 upper" "$($STL volume cut_upper.stl) $($STL open cut_upper.stl)" "$3 0"
+  expect "$1 $2 lower" "$($STL volume cut_lower.stl) $($STL open cut_lower.stl)" "$4 0"
+}
+
+$STL box 0,0,0 3,3,3 box.stl
+halves box.stl 0,0,1,1.5 13.5000 13.5000
+halves box.stl 1,1,1,4.5 13.5000 13.5000
+halves box.stl 1,1,1,3 22.5000 4.5000
+
+# Two boxes stacked, touching in the plane z = 2: nothing to cap.
+$STL box 0,0,0 20,10,2 base.stl
+$STL box 0,0,2 2,10,12 tower.stl
+$STL join step.stl base.stl tower.stl
+halves step.stl 0,0,1,2 200.0000 400.0000
+halves step.stl 0,0,-1,-2 400.0000 200.0000
+
+$STL torus 10 3 48 torus.stl
+for plane in 0,0,1,0 1,0,0,0 0,0,1,1.5; do
+  "$STOOL" --input torus.stl --cut $plane > /dev/null
+  expect "torus $plane closed" "$($STL open cut_upper.stl) $($STL open cut_lower.stl)" "0 0"
+  expect "torus $plane volume" \
+    "$(python3 -c "print('%.2f' % ($($STL volume cut_upper.stl) + $($STL volume cut_lower.stl)))")" \
+    "$(python3 -c "print('%.2f' % $($STL volume torus.stl))")"
+done
+
+rm -f cut_upper.stl cut_lower.stl
+for plane in 0,0,1,3 0,0,1,0 0,0,-1,0 0,0,1,50; do
+  fails "plane $plane" "$STOOL" --input box.stl --cut $plane
+done
+expect "nothing written" "$(ls cut_*.stl 2> /dev/null)" ""
+
+$STL cylinder 10 1 40000 cylinder.stl
+timeout 5 "$STOOL" --input cylinder.stl --cut 0,0,1,0.5 > /dev/null || fail "40k vertex cap loop"
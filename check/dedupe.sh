@@ -0,0 +1,31 @@
+#!/bin/sh
+# --split --dedupe: moved and turned copies share one part, other shapes get
+# their own, and every manifest transform puts its part back on the object.
+. "$(dirname "$0")/lib.sh"
+
+$STL box 0,0,0 3,1,1 bar.stl
+$STL move 10,0,0 bar.stl moved.stl
+$STL turn bar.stl turned.stl
+$STL move 0,20,0 turned.stl turned2.stl
+$STL box 0,-10,0 3,-9,2 tall.stl
+$STL sphere 2 8 sphere.stl
+$STL move 0,-20,0 sphere.stl sphere2.stl
+$STL join plate.stl bar.stl moved.stl turned2.stl tall.stl sphere2.stl
+
+mkdir plain parts
+(cd plain && "$STOOL" --input ../plate.stl --split > /dev/null)
+(cd parts && "$STOOL" --input ../plate.stl --split --dedupe > ../report)
+expect "unique" "$(cat report)" "Unique parts: 3"
+expect "parts" "$(ls parts/manifold_object_*.stl | wc -l)" "3"
+expect "instances" "$(grep -vc '^#' parts/manifold_instances.txt)" "5"
+expect "placed" "$($STL place parts/manifold_instances.txt plain)" "5"
+
+# A copy 0.00001 longer is the same part at the default tolerance only.
+$STL box 20,0,0 23.00001,1,1 longer.stl
+$STL join near.stl bar.stl longer.stl
+cd parts
+rm -f manifold_*
+expect "default tolerance" "$("$STOOL" --input ../near.stl --split --dedupe)" "Unique parts: 1"
+rm -f manifold_*
+expect "fine tolerance" "$("$STOOL" --input ../near.stl --split --dedupe --tolerance 0.000001)" \
+  "Unique parts: 2"
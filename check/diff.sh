@@ -0,0 +1,21 @@
+#!/bin/sh
+# --hash ignores facet order, start vertex and placement in the file;
+# --diff reports exactly the facets that changed; invalid inputs fail.
+. "$(dirname "$0")/lib.sh"
+
+$STL sphere 10 24 sphere.stl
+$STL box 20,0,0 21,1,1 box.stl
+$STL join ab.stl sphere.stl box.stl
+$STL join ba.stl box.stl sphere.stl
+expect "hash order" "$("$STOOL" --input ab.stl --hash)" "$("$STOOL" --input ba.stl --hash --threads 4)"
+
+"$STOOL" --diff sphere.stl ab.stl > report
+expect "diff" "$(tr '\n' ' ' < report)" "Removed facets: 0 Added facets: 12 "
+expect "added" "$($STL volume diff_added.stl)" "1.0000"
+
+head -c 1000 sphere.stl > truncated.stl
+printf 'garbage' > short.stl
+for bad in truncated.stl short.stl; do
+  fails "diff $bad" "$STOOL" --diff sphere.stl $bad
+  fails "hash $bad" "$STOOL" --input $bad --hash
+done
@@ -0,0 +1,21 @@
+#!/bin/sh
+# --hull: a convex part is its own hull, a concave one gets the expected
+# volume, and --split writes a closed hull per object.
+. "$(dirname "$0")/lib.sh"
+
+$STL sphere 10 32 sphere.stl
+expect "sphere" "$("$STOOL" --input sphere.stl --hull --output hull.stl)" "Hull volume: 4172"
+expect "sphere hull" "$($STL volume hull.stl) $($STL open hull.stl)" "$($STL volume sphere.stl) 0"
+
+# An L in XZ: the hull adds the triangle between the arms.
+$STL box 0,0,0 20,10,2 base.stl
+$STL box 0,0,2 2,10,12 tower.stl
+$STL join step.stl base.stl tower.stl
+expect "step" "$("$STOOL" --input step.stl --hull --threads 4 --output hull.stl)" "Hull volume: 1500"
+expect "step hull" "$($STL volume hull.stl) $($STL open hull.stl)" "1500.0000 0"
+
+$STL box 30,0,0 32,2,2 cube.stl
+$STL join plate.stl sphere.stl cube.stl
+"$STOOL" --input plate.stl --split --hull > report
+expect "split" "$(tr '\n' ' ' < report)" "Hull 0 volume: 4172 Hull 1 volume: 8 "
+expect "split hull" "$($STL volume manifold_hull_1.stl) $($STL open manifold_hull_1.stl)" "8.0000 0"
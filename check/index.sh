@@ -0,0 +1,26 @@
+#!/bin/sh
+# --index: the sidecar layout, answers that match a full read, and a
+# rebuild when the STL changes or the sidecar is damaged.
+. "$(dirname "$0")/lib.sh"
+
+$STL sphere 10 64 sphere.stl
+"$STOOL" --input sphere.stl --minmax --centroid > full
+"$STOOL" --input sphere.stl --index --minmax --centroid > built
+"$STOOL" --input sphere.stl --index --minmax --centroid > loaded
+expect "built" "$(cat built)" "$(cat full)"
+expect "loaded" "$(cat loaded)" "$(cat full)"
+
+# 64 byte header ("INDX", version 2, size, mtime, facets, chunk, bounds),
+# then 24 bytes of bounds per 4096 facets.
+facets=$($STL facets sphere.stl)
+expect "magic" "$(head -c 4 sphere.stl.idx)" "INDX"
+expect "layout" "$(wc -c < sphere.stl.idx)" "$((64 + 24 * ((facets + 4095) / 4096)))"
+
+printf '\377\377\377\377\377\377\377\017' | dd of=sphere.stl.idx bs=1 seek=24 conv=notrunc 2> /dev/null
+"$STOOL" --input sphere.stl --index --minmax --centroid > repaired
+expect "damaged sidecar" "$(cat repaired)" "$(cat full)"
+expect "rebuilt" "$(od -An -tu8 -j24 -N8 sphere.stl.idx | tr -d ' ')" "$facets"
+
+$STL box -1,-2,-3 1,2,3 sphere.stl
+"$STOOL" --input sphere.stl --index --minmax > changed
+expect "changed STL" "$(head -1 changed)" "X min: -1, X max: 1"
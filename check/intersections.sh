@@ -0,0 +1,18 @@
+#!/bin/sh
+# --check-intersections: overlapping objects are reported pair by pair,
+# separate and touching-free objects are not, whatever the thread count.
+. "$(dirname "$0")/lib.sh"
+
+$STL box 0,0,0 2,2,2 a.stl
+$STL box 1,1,1 3,3,3 b.stl
+$STL box 5,0,0 6,1,1 c.stl
+$STL join overlap.stl a.stl b.stl c.stl
+$STL join apart.stl a.stl c.stl
+
+"$STOOL" --input overlap.stl --check-intersections --threads 1 > one
+"$STOOL" --input overlap.stl --check-intersections --threads 4 > four
+expect "pair" "$(head -1 one)" "Objects 0,1 intersect: 18 facet pairs"
+expect "total" "$(tail -1 one)" "Intersections: 18"
+expect "threads" "$(cat four)" "$(cat one)"
+
+expect "apart" "$("$STOOL" --input apart.stl --check-intersections)" "Intersections: 0"
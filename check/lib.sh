@@ -0,0 +1,33 @@
+# Sourced by every check: runs in a scratch directory with the tool built
+# at the top of the tree, and stops at the first failure.
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+STOOL="$ROOT/stool"
+STL="python3 $ROOT/check/stl.py"
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cd "$WORK"
+
+
+fail() {
+  echo "FAIL $(basename "$0"): $*" >&2
+  exit 1
+}
+
+
+# expect <what> <actual> <expected>
+expect() {
+  [ "$2" = "$3" ] || fail "$1: got '$2', expected '$3'"
+}
+
+
+# fails <what> <command...>: the command must exit non-zero.
+fails() {
+  what=$1
+  shift
+  if "$@" > /dev/null 2>&1; then
+    fail "$what: succeeded"
+  fi
+}
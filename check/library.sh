@@ -0,0 +1,46 @@
+#!/bin/sh
+# libstool: invalid files give NULL, failures return -1, nothing is
+# written to stderr, and operations match the command line.
+. "$(dirname "$0")/lib.sh"
+
+$STL box 0,0,0 2,2,2 box.stl
+printf 'garbage' > short.stl
+
+cat > library.c <<'END'
+#include <stdio.h>
+#include <string.h>
+#include "stool.h"
+
+int
+main(void) {
+  char error[256];
+  float bounds[6], points[6] = { 1, 1, 1, 5, 1, 1 }, distances[2];
+
+  if (stool_open("short.stl", 1) || stool_open("missing.stl", 1) || stool_load("STL", 3, 1)) {
+    return 1;
+  }
+
+  stool_object *object = stool_open("box.stl", 2);
+  if (!object ||
+      stool_apply(object, "scale=2,2,2 translate=1,0,0", error, sizeof(error)) != 0 ||
+      stool_apply(object, "scale=2,2", error, sizeof(error)) != -1 || !error[0] ||
+      stool_minmax(object, bounds) != 0 ||
+      stool_query(object, points, 2, distances) != 0 ||
+      stool_save(object, "missing/out.stl") != -1 ||
+      stool_save(object, "out.stl") != 0) {
+    return 2;
+  }
+
+  printf("%g %g %g %g %g\n", bounds[0], bounds[1], bounds[5], distances[0], distances[1]);
+  stool_free(object);
+  return 0;
+}
+END
+
+cc -I"$ROOT" library.c "$ROOT/libstool.a" -lstdc++ -lm -lpthread -o library
+./library > output 2> errors
+expect "library" "$(cat output)" "0 4 3 -1 1"
+expect "stderr" "$(cat errors)" ""
+
+"$STOOL" --input box.stl --output cli.stl --scale 2,2,2 --translate 1,0,0
+expect "same as the command line" "$(cmp out.stl cli.stl && echo same)" "same"
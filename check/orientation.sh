@@ -0,0 +1,17 @@
+#!/bin/sh
+# --optimize-orientation: a tall pole is laid down, an L stands on both
+# arms without overhang, and the choice does not depend on threads.
+. "$(dirname "$0")/lib.sh"
+
+$STL box 0,0,0 1,1,10 pole.stl
+"$STOOL" --input pole.stl --optimize-orientation 512 --output laid.stl > one
+"$STOOL" --input pole.stl --optimize-orientation 512 --threads 4 > four
+expect "threads" "$(cat four)" "$(cat one)"
+expect "pole" "$(tail -3 one | tr '\n' ' ')" "Overhang area: 0 Support volume: 0 Z height: 1 "
+expect "laid down" "$("$STOOL" --input laid.stl --minmax | tail -1)" "Z min: -1, X max: 0"
+
+$STL box 0,0,0 20,10,2 base.stl
+$STL box 0,0,2 2,10,12 tower.stl
+$STL join step.stl base.stl tower.stl
+expect "step" "$("$STOOL" --input step.stl --optimize-orientation 512 | tail -3 | tr '\n' ' ')" \
+  "Overhang area: 0 Support volume: 0 Z height: 10 "
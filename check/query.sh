@@ -0,0 +1,27 @@
+#!/bin/sh
+# --query: signed distances to a box and a sphere match the exact values,
+# negative inside, on any threads; files that are not triples are refused.
+. "$(dirname "$0")/lib.sh"
+
+$STL box 0,0,0 2,2,2 box.stl
+$STL points box.bin 1,1,1 3,1,1 1,1,1.5 4,4,4 -1,1,1
+"$STOOL" --input box.stl --query box.bin > report
+expect "box report" "$(tr '\n' ' ' < report)" "Points: 5 Inside: 2 "
+expect "box" "$($STL floats box.dist)" "-1.0000 1.0000 -0.5000 3.4641 1.0000"
+
+# Facets lie inside the sphere, so points inside read slightly closer.
+$STL sphere 10 48 sphere.stl
+$STL points sphere.bin 0,0,0 0,0,15 5,5,0 20,0,0
+"$STOOL" --input sphere.stl --query sphere.bin --query-output one.dist --threads 1 > /dev/null
+"$STOOL" --input sphere.stl --query sphere.bin --query-output four.dist --threads 4 > /dev/null
+cmp one.dist four.dist || fail "distances differ across threads"
+python3 -c "
+import sys
+got = [float(x) for x in '$($STL floats one.dist)'.split()]
+want = [-10, 5, 50 ** 0.5 - 10, 10]
+sys.exit(any(abs(g - w) > 0.1 for g, w in zip(got, want)))" ||
+  fail "sphere distances $($STL floats one.dist)"
+
+printf 'abcde' > short.bin
+fails "partial triple" "$STOOL" --input box.stl --query short.bin
+fails "missing points" "$STOOL" --input box.stl --query missing.bin
@@ -0,0 +1,21 @@
+#!/bin/sh
+# --reorder: the same facets come back in curve order, close to their
+# neighbours, whatever the thread count; unknown curves are refused.
+. "$(dirname "$0")/lib.sh"
+
+$STL torus 10 3 64 torus.stl
+$STL shuffle torus.stl shuffled.stl
+hash=$("$STOOL" --input torus.stl --hash)
+for curve in morton hilbert; do
+  "$STOOL" --input shuffled.stl --output $curve.stl --reorder $curve --threads 1
+  "$STOOL" --input shuffled.stl --output ${curve}4.stl --reorder $curve --threads 4
+  cmp $curve.stl ${curve}4.stl || fail "$curve differs across threads"
+  expect "$curve hash" "$("$STOOL" --input $curve.stl --hash)" "$hash"
+  expect "$curve diff" "$("$STOOL" --diff shuffled.stl $curve.stl | tr '\n' ' ')" \
+    "Removed facets: 0 Added facets: 0 "
+  spread=$($STL spread $curve.stl)
+  python3 -c "import sys; sys.exit($spread > 1)" || fail "$curve spread $spread"
+done
+
+fails "unknown curve" "$STOOL" --input torus.stl --output peano.stl --reorder peano
+[ ! -e peano.stl ] || fail "unknown curve wrote peano.stl"
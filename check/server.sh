@@ -0,0 +1,32 @@
+#!/bin/sh
+# --serve: a bad file fails only its own command, failed writes reply ERR,
+# and the socket path is never taken from a file or a live server.
+. "$(dirname "$0")/lib.sh"
+
+$STL box 0,0,0 1,2,3 box.stl
+$STL box 0,0,0 1,2,3 bad.stl
+printf '\377\377' | dd of=bad.stl bs=1 seek=81 conv=notrunc 2> /dev/null
+printf 'garbage' > short.stl
+
+"$STOOL" --serve "$WORK/stool.sock" --threads 2 2> server.log &
+SERVER=$!
+trap 'kill $SERVER 2> /dev/null || true; rm -rf "$WORK"' EXIT
+for i in 1 2 3 4 5 6 7 8 9 10; do
+  [ -S stool.sock ] && break
+  sleep 0.2
+done
+
+printf 'stats %s\nstats %s\nstats %s\nsave %s %s\ntransform %s %s scale=2,2,2\nsave %s %s\n\n' \
+  "$WORK/bad.stl" "$WORK/short.stl" "$WORK/box.stl" "$WORK/box.stl" "$WORK/missing/out.stl" \
+  "$WORK/box.stl" "$WORK/missing/out.stl" "$WORK/box.stl" "$WORK/copy.stl" |
+  $STL send stool.sock | cut -c1-2 > replies
+expect "replies" "$(tr '\n' ' ' < replies)" "ER ER OK ER ER OK "
+expect "saved copy" "$(cmp box.stl copy.stl && echo same)" "same"
+
+fails "serve on a live socket" "$STOOL" --serve "$WORK/stool.sock"
+kill $SERVER
+wait $SERVER 2> /dev/null || true
+
+echo keep > model.stl
+fails "serve on a regular file" "$STOOL" --serve "$WORK/model.stl"
+expect "regular file kept" "$(cat model.stl)" "keep"
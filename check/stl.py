@@ -0,0 +1,309 @@
+#!/usr/bin/env python3
+# Fixtures and measurements for make check.
+#
+#   stl.py box x0,y0,z0 x1,y1,z1 out.stl      axis aligned box, 12 facets
+#   stl.py sphere radius segments out.stl     UV sphere about the origin
+#   stl.py torus major minor segments out.stl torus about the Z axis
+#   stl.py cylinder radius height segments out.stl
+#   stl.py join out.stl a.stl b.stl ...       concatenate facets, binary or ASCII
+#   stl.py move dx,dy,dz in.stl out.stl       translate
+#   stl.py turn in.stl out.stl                rotate 90 degrees about Z
+#   stl.py shuffle in.stl out.stl            facets in a fixed random order
+#   stl.py volume in.stl                      enclosed volume, 4 decimals
+#   stl.py open in.stl                        edges without a reversed twin
+#   stl.py facets in.stl                      facet count
+#   stl.py spread in.stl                      mean distance between consecutive
+#                                             facet centroids, 4 decimals
+#   stl.py points out.bin x,y,z ...           float32 query points
+#   stl.py floats in.bin                      float32 values, 4 decimals
+#   stl.py voxels grid.vox                    size, header count, decoded count
+#                                             and a digest of the filled voxels
+#   stl.py image in.png|in.ppm                size, distinct colours and a digest
+#                                             of the pixels; PNG chunk CRCs checked
+#   stl.py place manifest objects/            objects whose part, moved by its
+#                                             manifest transform, matches
+#                                             objects/manifold_object_N.stl
+#   stl.py send socket < batch                one batch, print the replies
+
+import math
+import random
+import socket
+import struct
+import sys
+import zlib
+
+
+def read(filename):
+    data = open(filename, 'rb').read()
+    if data.startswith(b'solid'):
+        v = [tuple(float(x) for x in line.split()[1:])
+             for line in data.decode().splitlines() if line.strip().startswith('vertex')]
+        return [tuple(v[i:i + 3]) for i in range(0, len(v), 3)]
+    count = struct.unpack_from('<I', data, 80)[0]
+    facets = []
+    for i in range(count):
+        v = struct.unpack_from('<12f', data, 84 + 50 * i)
+        facets.append((v[3:6], v[6:9], v[9:12]))
+    return facets
+
+
+def write(filename, facets):
+    with open(filename, 'wb') as out:
+        out.write(b'stool check'.ljust(80, b'\0'))
+        out.write(struct.pack('<I', len(facets)))
+        for a, b, c in facets:
+            out.write(struct.pack('<12fH', 0, 0, 0, *a, *b, *c, 0))
+
+
+def vector(text):
+    return tuple(float(x) for x in text.split(','))
+
+
+def box(lo, hi):
+    v = [(hi[0] if i & 1 else lo[0], hi[1] if i & 2 else lo[1], hi[2] if i & 4 else lo[2])
+         for i in range(8)]
+    quads = [(0, 2, 3, 1), (4, 5, 7, 6), (0, 1, 5, 4), (2, 6, 7, 3), (0, 4, 6, 2), (1, 3, 7, 5)]
+    facets = []
+    for q in quads:
+        facets.append((v[q[0]], v[q[1]], v[q[2]]))
+        facets.append((v[q[0]], v[q[2]], v[q[3]]))
+    return facets
+
+
+def grid(point, rows, columns):
+    # Quads over a closed (columns) by open or closed (rows) parameter grid.
+    facets = []
+    for i in range(rows):
+        for j in range(columns):
+            a, b = point(i, j), point(i, j + 1)
+            c, d = point(i + 1, j + 1), point(i + 1, j)
+            if a != b:
+                facets.append((a, c, b))
+            if c != d:
+                facets.append((a, d, c))
+    return facets
+
+
+def sphere(radius, n):
+    def point(i, j):
+        if i == 0 or i == n:
+            return (0.0, 0.0, radius if i == 0 else -radius)
+        t, p = math.pi * i / n, 2 * math.pi * (j % (2 * n)) / (2 * n)
+        return (radius * math.sin(t) * math.cos(p), radius * math.sin(t) * math.sin(p),
+                radius * math.cos(t))
+    return grid(point, n, 2 * n)
+
+
+def torus(major, minor, n):
+    def point(i, j):
+        u, v = 2 * math.pi * (i % n) / n, 2 * math.pi * (j % n) / n
+        r = major + minor * math.cos(v)
+        return (r * math.cos(u), r * math.sin(u), minor * math.sin(v))
+    return grid(point, n, n)
+
+
+def cylinder(radius, height, n):
+    rim = [(radius * math.cos(2 * math.pi * i / n), radius * math.sin(2 * math.pi * i / n))
+           for i in range(n)]
+    facets = []
+    for i in range(n):
+        a, b = rim[i], rim[(i + 1) % n]
+        facets.append(((a[0], a[1], 0), (b[0], b[1], 0), (b[0], b[1], height)))
+        facets.append(((a[0], a[1], 0), (b[0], b[1], height), (a[0], a[1], height)))
+        facets.append(((0, 0, 0), (b[0], b[1], 0), (a[0], a[1], 0)))
+        facets.append(((0, 0, height), (a[0], a[1], height), (b[0], b[1], height)))
+    return facets
+
+
+def volume(facets):
+    total = 0.0
+    for a, b, c in facets:
+        total += (a[0] * (b[1] * c[2] - b[2] * c[1]) + a[1] * (b[2] * c[0] - b[0] * c[2]) +
+                  a[2] * (b[0] * c[1] - b[1] * c[0]))
+    return total / 6
+
+
+def spread(facets):
+    centroids = [tuple(sum(v[k] for v in f) / 3 for k in range(3)) for f in facets]
+    return sum(math.dist(a, b) for a, b in zip(centroids, centroids[1:])) / (len(facets) - 1)
+
+
+def unmatched(facets):
+    edges = {}
+    for f in facets:
+        for k in range(3):
+            edge = (f[k], f[(k + 1) % 3])
+            edges[edge] = edges.get(edge, 0) + 1
+    return sum(n for (a, b), n in edges.items() if edges.get((b, a), 0) != n)
+
+
+def voxels(filename):
+    # 48 byte header, then raw column words or uint32 run lengths.
+    data = open(filename, 'rb').read()
+    magic, version, encoding, nx, ny, nz = struct.unpack_from('<4s5I', data, 0)
+    filled = struct.unpack_from('<Q', data, 40)[0]
+    columns = nx * ny
+    bits = bytearray(columns * nz)
+    if encoding == 0:
+        words = (nz + 63) // 64
+        for c in range(columns):
+            for k in range(nz):
+                word = struct.unpack_from('<Q', data, 48 + 8 * (c * words + k // 64))[0]
+                bits[c * nz + k] = word >> (k % 64) & 1
+    else:
+        runs = struct.unpack('<%dI' % ((len(data) - 48) // 4), data[48:])
+        at = 0
+        for i, run in enumerate(runs):
+            if i % 2:
+                bits[at:at + run] = b'\x01' * run
+            at += run
+        if at != len(bits):
+            sys.exit('runs cover %d of %d voxels' % (at, len(bits)))
+    digest = 0
+    for i, bit in enumerate(bits):
+        if bit:
+            digest = (digest * 31 + i) % (1 << 61)
+    return '%s %d,%d,%d %d %d %x' % (magic.decode(), nx, ny, nz, filled, sum(bits), digest)
+
+
+def unfilter(data, width, height):
+    # Undo the per-row PNG filters of 8 bit RGB.
+    stride, rows, prior, at = 3 * width, bytearray(), bytearray(3 * width), 0
+    for _ in range(height):
+        kind, row = data[at], bytearray(data[at + 1:at + 1 + stride])
+        at += 1 + stride
+        for i in range(stride):
+            a = row[i - 3] if i >= 3 else 0
+            b, c = prior[i], prior[i - 3] if i >= 3 else 0
+            if kind == 1:
+                row[i] = (row[i] + a) & 255
+            elif kind == 2:
+                row[i] = (row[i] + b) & 255
+            elif kind == 3:
+                row[i] = (row[i] + (a + b) // 2) & 255
+            elif kind == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                row[i] = (row[i] + (a if pa <= pb and pa <= pc else b if pb <= pc else c)) & 255
+        rows += row
+        prior = row
+    return bytes(rows)
+
+
+def image(filename):
+    data = open(filename, 'rb').read()
+    if data.startswith(b'P6'):
+        fields = data.split(maxsplit=4)
+        width, height = int(fields[1]), int(fields[2])
+        pixels = fields[4][:3 * width * height]
+    else:
+        if data[:8] != b'\x89PNG\r\n\x1a\n':
+            sys.exit('bad PNG signature')
+        at, idat = 8, b''
+        while at < len(data):
+            length, kind = struct.unpack_from('>I4s', data, at)
+            body = data[at + 8:at + 8 + length]
+            if struct.unpack_from('>I', data, at + 8 + length)[0] != zlib.crc32(kind + body):
+                sys.exit('bad %s CRC' % kind.decode())
+            if kind == b'IHDR':
+                width, height, depth, colour = struct.unpack_from('>IIBB', body)
+                if (depth, colour) != (8, 2):
+                    sys.exit('expected 8 bit RGB')
+            elif kind == b'IDAT':
+                idat += body
+            at += 12 + length
+        pixels = unfilter(zlib.decompress(idat), width, height)
+    colours = set(pixels[i:i + 3] for i in range(0, len(pixels), 3))
+    return '%dx%d %d %x' % (width, height, len(colours), zlib.crc32(pixels))
+
+
+def canonical(facets):
+    # Facets as rounded vertex cycles starting at their least vertex.
+    result = []
+    for f in facets:
+        f = [tuple(round(x, 3) + 0.0 for x in v) for v in f]
+        k = f.index(min(f))
+        result.append(tuple(f[k:] + f[:k]))
+    return sorted(result)
+
+
+def place(manifest, directory):
+    base, matched = manifest.rsplit('/', 1)[0] if '/' in manifest else '.', 0
+    for line in open(manifest):
+        if line.startswith('#'):
+            continue
+        fields = line.split()
+        r, t = [float(x) for x in fields[2:11]], [float(x) for x in fields[11:14]]
+        moved = [tuple(tuple(sum(r[3 * i + k] * v[k] for k in range(3)) + t[i] for i in range(3))
+                       for v in f) for f in read(base + '/' + fields[1])]
+        original = read('%s/manifold_object_%s.stl' % (directory, fields[0]))
+        matched += canonical(moved) == canonical(original)
+    return matched
+
+
+def send(path):
+    client = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    client.connect(path)
+    batch = sys.stdin.read()
+    client.sendall(batch.encode())
+    expected = len([line for line in batch.split('\n\n')[0].split('\n') if line.strip()])
+    replies = b''
+    while replies.count(b'\n') < expected:
+        chunk = client.recv(4096)
+        if not chunk:
+            break
+        replies += chunk
+    sys.stdout.write(replies.decode())
+
+
+def main(args):
+    command = args[0]
+    if command == 'box':
+        write(args[3], box(vector(args[1]), vector(args[2])))
+    elif command == 'sphere':
+        write(args[3], sphere(float(args[1]), int(args[2])))
+    elif command == 'torus':
+        write(args[4], torus(float(args[1]), float(args[2]), int(args[3])))
+    elif command == 'cylinder':
+        write(args[4], cylinder(float(args[1]), float(args[2]), int(args[3])))
+    elif command == 'join':
+        write(args[1], [f for name in args[2:] for f in read(name)])
+    elif command == 'move':
+        d = vector(args[1])
+        write(args[3], [tuple(tuple(v[k] + d[k] for k in range(3)) for v in f)
+                        for f in read(args[2])])
+    elif command == 'turn':
+        write(args[2], [tuple((-v[1], v[0], v[2]) for v in f) for f in read(args[1])])
+    elif command == 'shuffle':
+        facets = read(args[1])
+        random.Random(1).shuffle(facets)
+        write(args[2], facets)
+    elif command == 'volume':
+        print('%.4f' % volume(read(args[1])))
+    elif command == 'open':
+        print(unmatched(read(args[1])))
+    elif command == 'facets':
+        print(len(read(args[1])))
+    elif command == 'spread':
+        print('%.4f' % spread(read(args[1])))
+    elif command == 'points':
+        with open(args[1], 'wb') as out:
+            for p in args[2:]:
+                out.write(struct.pack('<3f', *vector(p)))
+    elif command == 'floats':
+        data = open(args[1], 'rb').read()
+        print(' '.join('%.4f' % x for x in struct.unpack('<%df' % (len(data) // 4), data)))
+    elif command == 'voxels':
+        print(voxels(args[1]))
+    elif command == 'image':
+        print(image(args[1]))
+    elif command == 'place':
+        print(place(args[1], args[2]))
+    elif command == 'send':
+        send(args[1])
+    else:
+        sys.exit('unknown command: ' + command)
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])
@@ -0,0 +1,18 @@
+#!/bin/sh
+# --thumbnail: the PNG passes its CRCs and inflates to the same pixels as the
+# PPM on any threads, and a shaded sphere shows more than the background.
+. "$(dirname "$0")/lib.sh"
+
+$STL sphere 10 24 sphere.stl
+"$STOOL" --input sphere.stl --thumbnail 64x48 --threads 1
+"$STOOL" --input sphere.stl --thumbnail 64x48 --thumbnail-output sphere.ppm --threads 4
+png=$($STL image sphere.png)
+expect "png and ppm" "$png" "$($STL image sphere.ppm)"
+expect "size" "${png%% *}" "64x48"
+colours=$(echo "$png" | cut -d' ' -f2)
+[ "$colours" -gt 8 ] || fail "only $colours colours"
+
+fails "bad size" "$STOOL" --input sphere.stl --thumbnail 64
+fails "zero size" "$STOOL" --input sphere.stl --thumbnail 0x48
+fails "missing directory" "$STOOL" --input sphere.stl --thumbnail 8x8 \
+  --thumbnail-output "$WORK/missing/sphere.png"
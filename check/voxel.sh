@@ -0,0 +1,20 @@
+#!/bin/sh
+# --voxelize: a box fills exactly, a torus comes close to its volume, and
+# the raw and run length files decode to the same voxels on any threads.
+. "$(dirname "$0")/lib.sh"
+
+$STL box 0,0,0 4,2,1 box.stl
+"$STOOL" --input box.stl --voxelize 8 --voxel-output box.vox > report
+expect "box" "$(tr '\n' ' ' < report)" "Voxels: 8,4,2 of 0.5 Filled voxels: 64 Filled volume: 8 "
+expect "box file" "$($STL voxels box.vox | cut -d' ' -f1-4)" "VOXB 8,4,2 64 64"
+
+# 48 byte header, then 64 bit words per column or uint32 runs.
+expect "raw layout" "$(wc -c < box.vox)" "$((48 + 8 * 8 * 4))"
+
+$STL torus 10 3 48 torus.stl
+"$STOOL" --input torus.stl --voxelize 96 --voxel-output torus.vox --threads 1 > /dev/null
+"$STOOL" --input torus.stl --voxelize 96 --voxel-output torus.rle --threads 4 > report
+expect "raw and runs" "$($STL voxels torus.rle)" "$($STL voxels torus.vox)"
+volume=$(sed -n 's/Filled volume: //p' report)
+python3 -c "import sys; sys.exit(abs($volume / $($STL volume torus.stl) - 1) > 0.02)" ||
+  fail "torus volume $volume"
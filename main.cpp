@@ -1,7 +1,12 @@
 #include <boost/program_options.hpp>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <unistd.h>
+#include <sys/sysinfo.h>
 #include "STLBIfc.hpp"
+#include "ServerSTL.hpp"
+#include "IndexSTL.hpp"
 
 namespace bpo = boost::program_options;
 int
@@ -16,21 +21,64 @@ main (
 
   desc.add_options()
    ("help,h",       "Help Screen.")
+   ("ascii",        "Write the output STL as ASCII instead of binary.")
+   ("array,a",      bpo::value<std::string>(),
+     "Replicate objects in a grid.  EG: --array [int,int,int|nx,ny,nz]")
+   ("cache-dir",    bpo::value<std::string>(),
+     "Reuse split/topology results keyed by facet content.  EG: --cache-dir ~/.cache/stool")
    ("centroid,c",   "Calculate and display centroid.")
    ("minmax,m",     "Calculate and display 3-plane min/max.")
+   ("check-intersections",
+     "Report intersecting and self-intersecting manifold objects.")
+   ("cut",          bpo::value<std::string>(),
+     "Cut into two closed halves, cut_upper.stl and cut_lower.stl, by the plane n.p = d.  EG: --cut [float,float,float,float|nx,ny,nz,d]")
+   ("dedupe",
+     "With --split, write identical parts once and their transforms to manifold_instances.txt.")
+   ("diff",         bpo::value<std::vector<std::string>>()->multitoken(),
+     "Report facets removed and added between two STL files, in any order, writing diff_removed.stl and diff_added.stl.  EG: --diff a.stl b.stl")
    ("dump,d",       "Dump STL contents.")
+   ("hash",
+     "Calculate and display a geometry hash independent of facet order and header.")
+   ("hull",
+     "Replace objects with their convex hull; with --split, write a hull per object.")
+   ("index",
+     "Answer --centroid/--minmax from a sidecar index (input.stl.idx), rewritten when the STL's size or modification time change.")
    ("input,i",      bpo::value(&input)->default_value("input.stl"),
       "Specify input STL file.  EG: --input input.stl"  )
+   ("optimize-orientation", bpo::value<size_t>()->implicit_value(4096),
+     "Rotate objects to the best scoring print orientation of N candidates.  EG: --optimize-orientation [4096]")
+   ("reorder",      bpo::value<std::string>(),
+     "Sort facets along a space filling curve for memory locality.  EG: --reorder [morton|hilbert]")
    ("output,o",     bpo::value(&output),
      "Specify output STL file. EG: --output output.stl")
+   ("query",        bpo::value<std::string>(),
+     "Signed distance (negative inside) to the surface for each float32 x,y,z triple in a file.  EG: --query points.bin")
+   ("query-output", bpo::value<std::string>(),
+     "Specify float32 distance file, one per point. DEFAULT : points name with .dist")
    ("rotate,r",     bpo::value<std::string>(),
      "Specify 3-plane angle (DEGREES) of rotation.  EG: --rotate [float,float,float|x,y,z]")
+   ("serve",        bpo::value<std::string>(),
+     "Run as a resident server on a Unix domain socket.  EG: --serve /tmp/stool.sock")
+   ("cache-bytes",  bpo::value<size_t>()->default_value(size_t(1) << 30),
+     "Specify the server cache budget in bytes. DEFAULT : 1GiB")
    ("scale,sc",     bpo::value<std::string>(),
      "Specify 3-plane scaling factor.  EG: --scale [float,float,float|x,y,z]")
+   ("spacing",      bpo::value<std::string>()->default_value("0,0,0"),
+     "Specify 3-plane gap between array copies.  EG: --spacing [float,float,float|x,y,z]")
    ("split,sp",
      "Split manifold objects into separate STL files.")
+   ("voxelize",     bpo::value<unsigned>(),
+     "Fill a voxel grid, N voxels along the longest side, and display its volume.  EG: --voxelize 1024")
+   ("voxel-output", bpo::value<std::string>(),
+     "Specify voxel grid file, run length encoded if named *.rle.  EG: --voxel-output grid.rle")
+   ("thumbnail",    bpo::value<std::string>(),
+     "Render a shaded preview of the given size.  EG: --thumbnail 256x256")
+   ("thumbnail-output", bpo::value<std::string>(),
+     "Specify preview file, PNG if named *.png, otherwise PPM. DEFAULT : input with .png")
    ("threads,th",   bpo::value<int>()->default_value(2),
      "Specify the number of threads to use. DEFAULT : 2")
+   ("tolerance",    bpo::value<float>()->default_value(1e-4f),
+     "Specify the grid vertices snap to for --hash and --diff, and the match distance for --dedupe. DEFAULT : 0.0001")
    ("translate,t",  bpo::value<std::string>(),
      "Specify Translation Vector. EG: --translate [float,float,float|x,y,z]");
 
@@ -38,16 +86,93 @@ main (
   bpo::store(bpo::parse_command_line(argc, argv, desc), vm);
   bpo::notify(vm);
 
+  if (vm.count("serve")) {
+    return ServerSTL::Serve(
+      vm["serve"].as<std::string>(),
+      vm["cache-bytes"].as<size_t>(),
+      vm["threads"].as<int>()
+    );
+  }
+
+  float tolerance = vm["tolerance"].as<float>();
+  if (!(tolerance > 0)) {
+    std::cerr << "Tolerance Argument ERROR: Expected a positive grid size.  EG: --tolerance 0.0001" << std::endl;
+    return -1;
+  }
+
+  if (vm.count("diff")) {
+    auto files = vm["diff"].as<std::vector<std::string>>();
+    if (files.size() != 2) {
+      std::cerr << "Diff Argument ERROR: Expected 2 STL files:  EG: --diff a.stl b.stl" << std::endl;
+      return -1;
+    }
+    for (auto &file : files) {
+      if (access(file.c_str(), F_OK) == -1 ) {
+        std::cerr << "ERROR: Invalid filename: " << file << std::endl;
+        return -1;
+      }
+    }
+
+    STLBObj a(files[0], vm["threads"].as<int>());
+    STLBObj b(files[1], vm["threads"].as<int>());
+    for (auto [file, object] : { std::pair{&files[0], &a}, std::pair{&files[1], &b} }) {
+      if (!object->Valid()) {
+        std::cerr << "ERROR: Invalid or Corrupt STLB: " << *file << std::endl;
+        return -1;
+      }
+    }
+    std::vector<STLFacetT> removed, added;
+    a.Diff(b, removed, added, tolerance);
+    std::cout << "Removed facets: " << removed.size() << std::endl
+              << "Added facets: " << added.size() << std::endl;
+
+    for (auto [filename, facets] : { std::pair{"diff_removed.stl", &removed},
+                                     std::pair{"diff_added.stl", &added} }) {
+      STLBObj difference(vm["threads"].as<int>());
+      for (auto &facet : *facets) {
+        difference.Add(facet);
+      }
+      difference.Save(filename);
+    }
+    return 0;
+  }
+
   if (access(input.c_str(), F_OK) == -1 ) {
     std::cerr << "ERROR: Invalid filename: " << input << std::endl;
     return -1;
   }
 
-  STLBObj source_stl(input, vm["threads"].as<int>());
+  IndexSTL::IndexT index;
+  bool indexed = vm.count("index") && IndexSTL::Update(input, vm["threads"].as<int>(), index);
+
+  // Facets are only read when something beyond the indexed stats needs them.
+  bool load = !indexed;
+  for (auto op : { "dump", "rotate", "translate", "scale", "optimize-orientation", "reorder",
+                   "array", "check-intersections", "voxelize", "query", "thumbnail", "cut",
+                   "split", "hull", "hash", "output" }) {
+    load = load || vm.count(op);
+  }
+
+  STLBObj source_stl = load ? STLBObj(input, vm["threads"].as<int>())
+                            : STLBObj(vm["threads"].as<int>());
+  if (!source_stl.Valid()) {
+    std::cerr << "ERROR: Invalid or Corrupt STLB: " << input << std::endl;
+    return -1;
+  }
+
+  if (vm.count("cache-dir")) {
+    source_stl.Cache(vm["cache-dir"].as<std::string>());
+  }
 
   if (vm.count("centroid")) {
     float x = 0, y = 0, z = 0;
-    source_stl.Centroid(x, y, z);
+    if (indexed) {
+      x = (index.m_Bounds[0] + index.m_Bounds[1]) / 2;
+      y = (index.m_Bounds[2] + index.m_Bounds[3]) / 2;
+      z = (index.m_Bounds[4] + index.m_Bounds[5]) / 2;
+    } else {
+      source_stl.Centroid(x, y, z);
+    }
     std::cout
       << "X,Y,Z Centroid: "
       << x << ","
@@ -59,7 +184,13 @@ main (
     float x[2];
     float y[2];
     float z[2];
-    source_stl.MinMax(x, y, z);
+    if (indexed) {
+      std::copy(&index.m_Bounds[0], &index.m_Bounds[2], x);
+      std::copy(&index.m_Bounds[2], &index.m_Bounds[4], y);
+      std::copy(&index.m_Bounds[4], &index.m_Bounds[6], z);
+    } else {
+      source_stl.MinMax(x, y, z);
+    }
     std::cout
       << "X min: " << x[0] << ", X max: " << x[1] << std::endl
       << "Y min: " << y[0] << ", X max: " << y[1] << std::endl
@@ -139,12 +270,274 @@ Expected 3 comma separates floats:  EG: 10,1,1" << std::endl;
 
   }
 
+  if (vm.count("optimize-orientation")) {
+    auto best = source_stl.OptimizeOrientation(vm["optimize-orientation"].as<size_t>());
+    std::cout
+      << "X,Y,Z Rotation (DEGREES): "
+      << best.m_Angle[0] * (180/M_PI) << ","
+      << best.m_Angle[1] * (180/M_PI) << ",0" << std::endl
+      << "Overhang area: " << best.m_Overhang << std::endl
+      << "Support volume: " << best.m_Support << std::endl
+      << "Z height: " << best.m_Height << std::endl;
+  }
+
+  if (vm.count("reorder")) {
+    auto curve = vm["reorder"].as<std::string>();
+    if (curve != "morton" && curve != "hilbert") {
+      std::cerr << "Reorder Argument ERROR: Expected morton or hilbert.  EG: --reorder hilbert" << std::endl;
+      return -1;
+    }
+    source_stl.Reorder(curve == "hilbert" ? CurveSTL::Curve::Hilbert : CurveSTL::Curve::Morton);
+  }
+
+  bool saved = false;
+
+  if (vm.count("array")) {
+    std::istringstream ss(vm["array"].as<std::string>());
+    std::istringstream ss_spacing(vm["spacing"].as<std::string>());
+    std::string token;
+    std::vector<std::string> count;
+    std::vector<std::string> spacing;
+    while(std::getline(ss, token, ',')) {
+      count.push_back(token);
+    }
+    while(std::getline(ss_spacing, token, ',')) {
+      spacing.push_back(token);
+    }
+
+    unsigned n[3];
+    float gap[3];
+    try {
+      if (count.size() != 3 || spacing.size() != 3) {
+        throw std::runtime_error("Expected 3 arguments.");
+      }
+
+      for (int k = 0; k < 3; k++) {
+        n[k] = std::stoul(count[k]);
+        gap[k] = std::stof(spacing[k]);
+      }
+    } catch (const std::exception& ex) {
+      std::cerr << "Array Argument ERROR: \
+Expected 3 comma separated counts and spacings:  EG:  --array 4,4,1 --spacing 2,2,0" << std::endl;
+      return -1;
+    }
+
+    // Stream straight to the output when it is the only consumer of the
+    // copies and they would take more than half of physical memory.
+    struct sysinfo info;
+    size_t bytes = source_stl.Bytes() * n[0] * n[1] * n[2];
+    bool stream = vm.count("output") && sysinfo(&info) == 0 &&
+                  bytes > (size_t(info.totalram) * info.mem_unit) / 2;
+    for (auto op : { "ascii", "check-intersections", "voxelize", "query", "thumbnail", "cut",
+                     "split", "hull", "hash" }) {
+      stream = stream && !vm.count(op);
+    }
+
+    if (stream) {
+      saved = true;
+      if (!source_stl.Array(n, gap, output)) {
+        return -1;
+      }
+    } else if (!source_stl.Array(n, gap)) {
+      return -1;
+    }
+  }
+
+  if (vm.count("check-intersections")) {
+    std::vector<STLIntersectionT> intersections;
+    source_stl.Intersections(intersections);
+
+    for (size_t i = 0, j = 0; i < intersections.size(); i = j) {
+      const auto &pair = intersections[i];
+      while (j < intersections.size() &&
+             intersections[j].m_Object[0] == pair.m_Object[0] &&
+             intersections[j].m_Object[1] == pair.m_Object[1]) {
+        j++;
+      }
+
+      if (pair.m_Object[0] == pair.m_Object[1]) {
+        std::cout << "Object " << pair.m_Object[0] << " self-intersects: ";
+      } else {
+        std::cout << "Objects " << pair.m_Object[0] << "," << pair.m_Object[1] << " intersect: ";
+      }
+      std::cout << (j - i) << " facet pairs" << std::endl;
+
+      for (size_t k = i; k < j; k++) {
+        std::cout << "\tFacets: "
+                  << intersections[k].m_Facet[0] << ","
+                  << intersections[k].m_Facet[1] << std::endl;
+      }
+    }
+
+    std::cout << "Intersections: " << intersections.size() << std::endl;
+  }
+
+  if (vm.count("voxelize")) {
+    VoxelSTL::GridT grid;
+    if (!source_stl.Voxelize(vm["voxelize"].as<unsigned>(), grid)) {
+      std::cerr << "Voxelize Argument ERROR: \
+Expected a positive resolution and a non-empty object:  EG: 1024" << std::endl;
+      return -1;
+    }
+
+    size_t filled = VoxelSTL::Filled(grid, vm["threads"].as<int>());
+    std::cout
+      << "Voxels: " << grid.m_Size[0] << "," << grid.m_Size[1] << "," << grid.m_Size[2]
+      << " of " << grid.m_Voxel << std::endl
+      << "Filled voxels: " << filled << std::endl
+      << "Filled volume: " << filled * double(grid.m_Voxel) * grid.m_Voxel * grid.m_Voxel
+      << std::endl;
+
+    if (vm.count("voxel-output")) {
+      auto filename = vm["voxel-output"].as<std::string>();
+      bool rle = filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".rle") == 0;
+      if (!VoxelSTL::Save(filename, grid, rle, vm["threads"].as<int>())) {
+        std::cerr << "ERROR: Unable to write: " << filename << std::endl;
+        return -1;
+      }
+    }
+  }
+
+  if (vm.count("query")) {
+    auto points_file = vm["query"].as<std::string>();
+    std::ifstream points_input{points_file, std::ios::binary | std::ios::ate};
+    std::streamoff length = points_input ? std::streamoff(points_input.tellg()) : -1;
+    if (length < 0 || length % (3 * sizeof(float))) {
+      std::cerr << "Query Argument ERROR: \
+Expected a file of float32 x,y,z triples:  EG: --query points.bin" << std::endl;
+      return -1;
+    }
+
+    size_t count = length / (3 * sizeof(float));
+    std::vector<float> points(3 * count);
+    std::vector<float> distances(count);
+    points_input.seekg(0);
+    points_input.read(reinterpret_cast<char*>(points.data()), length);
+    if (!points_input || !source_stl.Query(points.data(), count, distances.data())) {
+      std::cerr << "ERROR: Unable to query: " << points_file << std::endl;
+      return -1;
+    }
+
+    size_t inside = std::count_if(distances.begin(), distances.end(), [](float d) { return d < 0; });
+    std::cout << "Points: " << count << std::endl
+              << "Inside: " << inside << std::endl;
+
+    std::string filename = points_file.substr(0, points_file.rfind('.')) + ".dist";
+    if (vm.count("query-output")) {
+      filename = vm["query-output"].as<std::string>();
+    }
+    std::ofstream distances_output{filename, std::ios::binary | std::ios::out};
+    distances_output.write(reinterpret_cast<const char*>(distances.data()), count * sizeof(float));
+    if (!distances_output) {
+      std::cerr << "ERROR: Unable to write: " << filename << std::endl;
+      return -1;
+    }
+  }
+
+  if (vm.count("thumbnail")) {
+    RenderSTL::ImageT image;
+    try {
+      auto size = vm["thumbnail"].as<std::string>();
+      auto x = size.find('x');
+      if (x == std::string::npos) {
+        throw std::runtime_error("Expected WxH.");
+      }
+      image.m_Width = std::stoul(size.substr(0, x));
+      image.m_Height = std::stoul(size.substr(x + 1));
+      if (image.m_Width == 0 || image.m_Height == 0) {
+        throw std::runtime_error("Expected WxH.");
+      }
+    } catch (const std::exception& ex) {
+      std::cerr << "Thumbnail Argument ERROR: \
+Expected positive width and height:  EG: 256x256" << std::endl;
+      return -1;
+    }
+
+    std::string filename = input.substr(0, input.rfind('.')) + ".png";
+    if (vm.count("thumbnail-output")) {
+      filename = vm["thumbnail-output"].as<std::string>();
+    }
+
+    source_stl.Render(image);
+    if (!RenderSTL::Save(filename, image)) {
+      std::cerr << "ERROR: Unable to write: " << filename << std::endl;
+      return -1;
+    }
+  }
+
+  if (vm.count("cut")) {
+    std::istringstream ss(vm["cut"].as<std::string>());
+    std::string token;
+    std::vector<std::string> plane_string;
+    while(std::getline(ss, token, ',')) {
+      plane_string.push_back(token);
+    }
+
+    float plane[4];
+    long loops = -1;
+    try {
+      if (plane_string.size() != 4) {
+        throw std::runtime_error("Expected 4 arguments.");
+      }
+      for (int k = 0; k < 4; k++) {
+        plane[k] = std::stof(plane_string[k]);
+      }
+      loops = source_stl.Cut(plane);
+    } catch (const std::exception&) {
+      loops = -1;
+    }
+
+    if (loops == -2) {
+      std::cerr << "Cut ERROR: The plane does not cross the mesh." << std::endl;
+      return -1;
+    }
+    if (loops < 0) {
+      std::cerr << "Cut Argument ERROR: \
+Expected a non-zero normal and offset, 4 comma separated floats:  EG: --cut 0,0,1,25" << std::endl;
+      return -1;
+    }
+    std::cout << "Cut loops: " << loops << std::endl;
+  }
+
   if (vm.count("split")) {
-    source_stl.Split();
+    if (vm.count("dedupe")) {
+      size_t parts = source_stl.SplitUnique(tolerance);
+      std::cout << "Unique parts: " << parts << std::endl;
+    } else {
+      source_stl.Split();
+    }
   }
 
-  if (vm.count("output")) {
-    source_stl.Save(output);
+  if (vm.count("hull")) {
+    if (vm.count("split")) {
+      std::vector<float> volumes;
+      source_stl.Hulls(volumes);
+      for (size_t n = 0; n < volumes.size(); n++) {
+        std::cout << "Hull " << n << " volume: " << volumes[n] << std::endl;
+      }
+    } else {
+      float volume = 0;
+      if (!source_stl.Hull(volume)) {
+        std::cerr << "Hull ERROR: degenerate (flat or empty) input." << std::endl;
+        return -1;
+      }
+      std::cout << "Hull volume: " << volume << std::endl;
+    }
+  }
+
+  if (vm.count("hash")) {
+    std::ios flags(nullptr);
+    flags.copyfmt(std::cout);
+    std::cout << "Hash: " << std::hex << std::setw(16) << std::setfill('0')
+              << source_stl.Hash(tolerance) << std::endl;
+    std::cout.copyfmt(flags);
+  }
+
+  if (vm.count("output") && !saved) {
+    if (!(vm.count("ascii") ? source_stl.SaveAscii(output) : source_stl.Save(output))) {
+      std::cerr << "ERROR: Unable to write: " << output << std::endl;
+      return -1;
+    }
   }
 
   if (vm.count("help")) {
@@ -0,0 +1,93 @@
+#ifndef STOOL_H
+#define STOOL_H
+
+/*
+ * C interface to libstool.  Symbols are versioned (STOOL_1) and the layout of
+ * everything below only changes with STOOL_ABI_VERSION.
+ *
+ * Functions returning int return 0 on success and -1 on failure; a failure
+ * with an error buffer fills it with a NUL terminated message.  An object is
+ * not thread safe, but distinct objects may be used from distinct threads.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STOOL_ABI_VERSION 1
+
+/* Bytes before the first facet of a binary STL image. */
+#define STOOL_HEADER_SIZE 84
+
+typedef struct stool_object stool_object;
+
+#pragma pack(push, 1)
+typedef struct stool_facet {
+    float       normal[3];
+    float       vertex1[3];
+    float       vertex2[3];
+    float       vertex3[3];
+    uint16_t    attr;
+} stool_facet;
+#pragma pack(pop)
+
+/* A view into an object's storage; valid until the object is next
+ * modified or freed. */
+typedef struct stool_facets {
+    const stool_facet  *data;
+    size_t              count;
+} stool_facets;
+
+typedef struct stool_bytes {
+    const void         *data;
+    size_t              length;
+} stool_bytes;
+
+
+unsigned
+stool_abi_version(void);
+
+/* Load a binary STL from a file, or copy one from memory.  NULL if it is
+ * not a valid binary STL. */
+stool_object *
+stool_open(const char *filename, int threads);
+
+stool_object *
+stool_load(const void *data, size_t length, int threads);
+
+void
+stool_free(stool_object *object);
+
+/* Apply whitespace separated operations in order, as the server's
+ * transform command takes them: rotate=x,y,z (DEGREES), scale=x,y,z,
+ * translate=x,y,z.  Nothing is applied if any operation is malformed. */
+int
+stool_apply(stool_object *object, const char *operations, char *error, size_t error_length);
+
+/* Facets, and the whole binary STL image including its header. */
+stool_facets
+stool_view(stool_object *object);
+
+stool_bytes
+stool_image(stool_object *object);
+
+/* Bounds as { xMin, xMax, yMin, yMax, zMin, zMax }. */
+int
+stool_minmax(stool_object *object, float bounds[6]);
+
+/* Signed distance from each of count points, packed x, y, z, to the
+ * surface, negative inside, into distances[count]. */
+int
+stool_query(stool_object *object, const float *points, size_t count, float *distances);
+
+int
+stool_save(stool_object *object, const char *filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STOOL_H */